@@ -0,0 +1,45 @@
+#include "Arguments.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+    [[noreturn]] void Reject(const char *expected, const char *value, const std::string &usage) {
+        std::cerr << "Expected " << expected << ", got: " << value << std::endl;
+        std::cerr << usage << std::endl;
+        exit(1);
+    }
+
+}
+
+uint32_t ParseUnsigned(const char *value, const std::string &usage, bool allow_zero) {
+    const char *expected = allow_zero ? "a non-negative integer" : "a positive integer";
+    // strtoul accepts a sign and wraps negative values around, so only digits are let through
+    if (*value < '0' || *value > '9') Reject(expected, value, usage);
+
+    char *end = nullptr;
+    errno = 0;
+    unsigned long parsed = std::strtoul(value, &end, 10);
+    if (*end != '\0' || errno == ERANGE || parsed > std::numeric_limits<uint32_t>::max() || (parsed == 0 && !allow_zero))
+        Reject(expected, value, usage);
+    return static_cast<uint32_t>(parsed);
+}
+
+float ParsePositiveFloat(const char *value, const std::string &usage) {
+    char *end = nullptr;
+    float parsed = std::strtof(value, &end);
+    if (end == value || *end != '\0' || !(parsed > 0.0f) || std::isinf(parsed))
+        Reject("a positive number", value, usage);
+    return parsed;
+}
+
+float ParseNonNegativeFloat(const char *value, const std::string &usage) {
+    char *end = nullptr;
+    float parsed = std::strtof(value, &end);
+    if (end == value || *end != '\0' || !(parsed >= 0.0f) || std::isinf(parsed))
+        Reject("a non-negative number", value, usage);
+    return parsed;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Command line value parsers shared by the app and the benchmark. On malformed input they print
+ * the expected form and `usage`, then exit with status 1.
+ */
+
+/** @brief Parses a decimal integer that fits in 32 bits. Zero is rejected unless `allow_zero` is set. */
+uint32_t ParseUnsigned(const char *value, const std::string &usage, bool allow_zero = false);
+
+/** @brief Parses a finite number greater than zero. */
+float ParsePositiveFloat(const char *value, const std::string &usage);
+
+/** @brief Parses a finite number greater than or equal to zero. */
+float ParseNonNegativeFloat(const char *value, const std::string &usage);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Materials/Material.h"
+#include "Scene/Scene.h"
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Appends every mesh in `filename` to `scene`, transformed by `modelToWorld`. Throws if the file cannot be read.
+ * `bvh_format` selects the node format of the meshes' BVHs, quantized nodes suit very large models.
+ */
+void LoadModel(const std::string &filename,
+               Scene::Scene &scene,
+               std::shared_ptr<Materials::Material> material,
+               const glm::mat4 &modelToWorld = glm::mat4(1.0f),
+               Geometry::BVHFormat bvh_format = Geometry::BVHFormat::Float);
+
+std::shared_ptr<Scene::Scene> BasicTriangleScene();
+std::shared_ptr<Scene::Scene> Scene0();
+std::shared_ptr<Scene::Scene> Scene1();
+std::shared_ptr<Scene::Scene> Scene2();
+std::shared_ptr<Scene::Scene> Scene3();
+std::shared_ptr<Scene::Scene> Scene4();
+
+struct NamedScene {
+    const char *name;
+    std::shared_ptr<Scene::Scene> (*create)();
+};
+
+/** @brief The scenes above by name, e.g. for benchmarks that run all of them. */
+const std::vector<NamedScene> &BuiltinScenes();
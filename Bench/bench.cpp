@@ -0,0 +1,224 @@
+#include "Arguments.h"
+#include "Scenes.h"
+#include "Renderer/IterativeTracer.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/WhittedTracer.h"
+#include "Utils/RayStats.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/resource.h>
+#endif
+
+/*
+ * Renders the built-in scenes headless at a fixed resolution, sample count and seed and reports
+ * timings as JSON, so that runs can be compared across versions.
+ */
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct BenchOptions {
+        uint32_t width = 320;
+        uint32_t height = 240;
+        uint32_t samples_per_pixel = 16;
+        uint32_t seed = 1;
+        float adaptive_threshold = 0.0f;
+        bool iterative_tracer = true;
+        std::vector<std::string> scenes {};
+        std::string output = "";
+    };
+
+    struct BenchResult {
+        std::string scene;
+        double setup_ms = 0.0;      // scene construction
+        double build_ms = 0.0;      // acceleration structures
+        double render_ms = 0.0;     // all RenderToFilm calls
+        double resolve_ms = 0.0;    // film conversion to bytes
+        uint32_t frames = 0;
+        size_t acceleration_bytes = 0;
+        Utils::RayCounts rays {};
+    };
+
+    double ElapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    /**
+     * @brief Peak resident set size of the process so far, 0 where it cannot be queried. The peak
+     * never drops, so it is only reported once for the whole run and not per scene.
+     */
+    double PeakRssMb() {
+    #if defined(__unix__) || defined(__APPLE__)
+        rusage usage {};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+        #if defined(__APPLE__)
+            return double(usage.ru_maxrss) / (1024.0 * 1024.0);   // bytes
+        #else
+            return double(usage.ru_maxrss) / 1024.0;              // kilobytes
+        #endif
+    #else
+        return 0.0;
+    #endif
+    }
+
+    BenchResult RunScene(const NamedScene &named, const BenchOptions &options) {
+        BenchResult result;
+        result.scene = named.name;
+
+        auto start = Clock::now();
+        std::shared_ptr<Scene::Scene> scene = named.create();
+        result.setup_ms = ElapsedMs(start);
+
+        std::unique_ptr<Renderer::Tracer> tracer;
+        if (options.iterative_tracer) tracer = std::make_unique<Renderer::IterativeTracer>();
+        else tracer = std::make_unique<Renderer::WhittedTracer>();
+
+        Renderer::Renderer renderer { options.width, options.height, VK_FORMAT_R8G8B8A8_SRGB, options.samples_per_pixel, std::move(tracer) };
+
+        start = Clock::now();
+        scene->Build(&renderer.Scheduler());
+        result.build_ms = ElapsedMs(start);
+        result.acceleration_bytes = scene->AccelerationStructureBytes();
+        renderer.SetSeed(options.seed);
+        renderer.SetSampleOrder(Renderer::SampleOrder::Tiled);
+        renderer.SetVerbose(false);
+        renderer.SetAdaptiveSampling(options.adaptive_threshold);
+        renderer.SetFrameBudget(Renderer::Renderer::HEADLESS_FRAME_BUDGET_MS);
+
+        scene->GetCamera().SetImageSize(options.width, options.height);
+        scene->GetCamera().Update();
+
+        // RenderToFilm reports completion on the call after the last frame, which renders nothing,
+        // so every call that returns false is a frame, the final one included
+        const Utils::RayCounts rays_before = Utils::RayStats::Snapshot();
+        Renderer::Film *film = nullptr;
+        bool render_complete = false;
+        start = Clock::now();
+        while (!render_complete) {
+            auto [frame_film, complete] = renderer.RenderToFilm(*scene);
+            film = &frame_film;
+            render_complete = complete;
+            if (!complete) result.frames++;
+        }
+        result.render_ms = ElapsedMs(start);
+        result.rays = Utils::RayStats::Snapshot() - rays_before;
+
+        // Only the conversion of the accumulated film to bytes
+        start = Clock::now();
+        film->Data();
+        result.resolve_ms = ElapsedMs(start);
+
+        return result;
+    }
+
+    void WriteJson(std::ostream &out, const BenchOptions &options, const std::vector<BenchResult> &results, double peak_rss_mb) {
+        out << std::fixed << std::setprecision(3);
+        out << "{\n"
+            << "  \"width\": " << options.width << ",\n"
+            << "  \"height\": " << options.height << ",\n"
+            << "  \"spp\": " << options.samples_per_pixel << ",\n"
+            << "  \"seed\": " << options.seed << ",\n"
+            << "  \"adaptive_threshold\": " << options.adaptive_threshold << ",\n"
+            << "  \"tracer\": \"" << (options.iterative_tracer ? "iterative" : "whitted") << "\",\n"
+            << "  \"peak_rss_mb\": " << peak_rss_mb << ",\n"
+            << "  \"scenes\": [";
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchResult &r = results[i];
+            const double wall_ms = r.setup_ms + r.build_ms + r.render_ms + r.resolve_ms;
+            const double mrays_per_second = r.render_ms > 0.0 ? double(r.rays.Rays()) / (r.render_ms * 1e3) : 0.0;
+
+            out << (i == 0 ? "\n" : ",\n")
+                << "    {\n"
+                << "      \"name\": \"" << r.scene << "\",\n"
+                << "      \"wall_ms\": " << wall_ms << ",\n"
+                << "      \"mrays_per_second\": " << mrays_per_second << ",\n"
+                << "      \"frames\": " << r.frames << ",\n"
+                << "      \"bvh_bytes\": " << r.acceleration_bytes << ",\n"
+                << "      \"phases_ms\": { \"setup\": " << r.setup_ms << ", \"build\": " << r.build_ms
+                << ", \"render\": " << r.render_ms << ", \"resolve\": " << r.resolve_ms << " },\n"
+                << "      \"rays\": { \"primary\": " << r.rays.primary_rays << ", \"secondary\": " << r.rays.secondary_rays
+                << ", \"shadow\": " << r.rays.shadow_rays << " },\n"
+                << "      \"tests\": { \"box\": " << r.rays.box_tests << ", \"primitive\": " << r.rays.primitive_tests
+                << ", \"triangle\": " << r.rays.triangle_tests << " }\n"
+                << "    }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+}
+
+int main(int argc, char **argv) {
+    try {
+        BenchOptions options;
+        std::string valid_usage_str = "\tUsage raytracer_bench [--width w] [--height h] [--spp n] [--seed s] [--adaptive threshold] [--scene name]... [--tracer iterative|whitted] [--output file.json]";
+
+        for (int i = 1; i < argc; ++i) {
+            if (i + 1 >= argc) {
+                std::cerr << valid_usage_str << std::endl;
+                return 1;
+            }
+
+            if (std::strcmp(argv[i], "--width") == 0) options.width = ParseUnsigned(argv[i + 1], valid_usage_str);
+            else if (std::strcmp(argv[i], "--height") == 0) options.height = ParseUnsigned(argv[i + 1], valid_usage_str);
+            else if (std::strcmp(argv[i], "--spp") == 0) options.samples_per_pixel = ParseUnsigned(argv[i + 1], valid_usage_str);
+            else if (std::strcmp(argv[i], "--seed") == 0) options.seed = ParseUnsigned(argv[i + 1], valid_usage_str, true);
+            else if (std::strcmp(argv[i], "--adaptive") == 0) options.adaptive_threshold = ParseNonNegativeFloat(argv[i + 1], valid_usage_str);
+            else if (std::strcmp(argv[i], "--scene") == 0) options.scenes.push_back(argv[i + 1]);
+            else if (std::strcmp(argv[i], "--output") == 0) options.output = argv[i + 1];
+            else if (std::strcmp(argv[i], "--tracer") == 0 && (std::strcmp(argv[i + 1], "iterative") == 0 || std::strcmp(argv[i + 1], "whitted") == 0))
+                options.iterative_tracer = std::strcmp(argv[i + 1], "iterative") == 0;
+            else {
+                std::cerr << "Unknown argument: " << argv[i] << std::endl;
+                std::cerr << valid_usage_str << std::endl;
+                return 1;
+            }
+            i++;
+        }
+
+        std::vector<NamedScene> selected;
+        for (const NamedScene &scene : BuiltinScenes()) {
+            bool wanted = options.scenes.empty();
+            for (const std::string &name : options.scenes)
+                wanted |= name == scene.name;
+            if (wanted) selected.push_back(scene);
+        }
+        if (selected.empty()) {
+            std::cerr << "No scene matches the given --scene names" << std::endl;
+            return 1;
+        }
+
+        std::vector<BenchResult> results;
+        for (const NamedScene &scene : selected) {
+            std::cerr << "Rendering " << scene.name << "..." << std::endl;
+            results.push_back(RunScene(scene, options));
+        }
+        const double peak_rss_mb = PeakRssMb();
+
+        if (options.output.empty()) {
+            WriteJson(std::cout, options, results, peak_rss_mb);
+        } else {
+            std::ofstream file(options.output);
+            if (!file) {
+                std::cerr << "Could not open " << options.output << std::endl;
+                return 1;
+            }
+            WriteJson(file, options, results, peak_rss_mb);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Uncaught exception: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
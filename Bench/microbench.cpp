@@ -0,0 +1,256 @@
+#include "Geometry/Sphere.h"
+#include "Geometry/TriangleMesh.h"
+#include "Materials/Dielectric.h"
+#include "Materials/Diffuse.h"
+#include "Renderer/Film.h"
+#include "Scene/Camera.h"
+#include "Scene/PointLight.h"
+#include "Scene/Scene.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Microbenchmarks of the intersection and shading kernels on synthetic, pre-generated batches.
+ * Each kernel runs over its batch until a minimum time has passed and reports the time per
+ * operation, which isolates layout and SIMD changes from the rest of the frame.
+ */
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t BATCH_SIZE = 1u << 16;
+
+    // Results are folded into this so that the kernels cannot be optimized away
+    volatile float g_sink = 0.0f;
+
+    struct BenchOptions {
+        double min_seconds = 0.25;
+        std::string filter = "";
+    };
+
+    /**
+     * @brief Calls `kernel(i)` for every i in [0, batch) until `min_seconds` have passed and
+     * prints ns/op and throughput. `ops_per_call` scales calls to the reported unit.
+     */
+    template <typename Kernel>
+    void Run(const BenchOptions &options, const std::string &name, uint32_t batch, double ops_per_call, const char *unit, Kernel &&kernel) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+            return;
+
+        for (uint32_t i = 0; i < batch; ++i) kernel(i);   // warm up caches and lazy state
+
+        uint64_t calls = 0;
+        const auto start = Clock::now();
+        double seconds = 0.0;
+        do {
+            for (uint32_t i = 0; i < batch; ++i) kernel(i);
+            calls += batch;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (seconds < options.min_seconds);
+
+        const double ops = double(calls) * ops_per_call;
+        std::cout << std::left << std::setw(36) << name << std::right << std::fixed
+                  << std::setw(10) << std::setprecision(2) << seconds * 1e9 / ops << " ns/op"
+                  << std::setw(12) << std::setprecision(2) << ops / seconds * 1e-6 << " M" << unit << "/s"
+                  << '\n';
+    }
+
+    glm::vec3 RandomInBall(std::mt19937 &gen, float radius) {
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        glm::vec3 p;
+        do { p = { dist(gen), dist(gen), dist(gen) }; } while (glm::dot(p, p) > 1.0f);
+        return p * radius;
+    }
+
+    glm::vec3 RandomDirection(std::mt19937 &gen) {
+        glm::vec3 p;
+        do { p = RandomInBall(gen, 1.0f); } while (glm::dot(p, p) < 1e-4f);
+        return glm::normalize(p);
+    }
+
+    /** @brief Rays from a shell around the origin aimed into a ball, roughly half of them hit a unit sphere. */
+    std::vector<Geometry::Ray> RaysTowardsOrigin(std::mt19937 &gen, float shell_radius, float target_radius) {
+        std::vector<Geometry::Ray> rays;
+        rays.reserve(BATCH_SIZE);
+        for (uint32_t i = 0; i < BATCH_SIZE; ++i) {
+            glm::vec3 origin = RandomDirection(gen) * shell_radius;
+            glm::vec3 target = RandomInBall(gen, target_radius);
+            rays.emplace_back(origin, glm::normalize(target - origin));
+        }
+        return rays;
+    }
+
+    void BenchSphere(const BenchOptions &options, std::mt19937 &gen) {
+        auto material = std::make_shared<Materials::Diffuse>(Color(1.0f));
+        Geometry::Sphere sphere { glm::vec3(0.0f), 1.0f, material };
+        const auto rays = RaysTowardsOrigin(gen, 5.0f, 1.5f);
+
+        Run(options, "Sphere::Intersect", BATCH_SIZE, 1.0, "rays", [&](uint32_t i) {
+            if (auto hit = sphere.Intersect(rays[i])) g_sink = g_sink + hit->Time();
+        });
+    }
+
+    void BenchTriangleMesh(const BenchOptions &options, std::mt19937 &gen) {
+        // Bumpy 64 x 64 quad grid over [-1, 1]^2, 8192 triangles
+        constexpr uint32_t GRID = 64;
+        std::uniform_real_distribution<float> bump(-0.05f, 0.05f);
+
+        std::vector<glm::vec3> positions;
+        for (uint32_t y = 0; y <= GRID; ++y)
+            for (uint32_t x = 0; x <= GRID; ++x)
+                positions.emplace_back(2.0f * float(x) / GRID - 1.0f, 2.0f * float(y) / GRID - 1.0f, bump(gen));
+
+        std::vector<uint32_t> indices;
+        for (uint32_t y = 0; y < GRID; ++y) {
+            for (uint32_t x = 0; x < GRID; ++x) {
+                uint32_t i = y * (GRID + 1) + x;
+                indices.insert(indices.end(), { i, i + 1, i + GRID + 1, i + 1, i + GRID + 2, i + GRID + 1 });
+            }
+        }
+
+        auto material = std::make_shared<Materials::Diffuse>(Color(1.0f));
+        Geometry::TriangleMesh mesh { material };
+        mesh.SetVertices(positions);
+        mesh.SetIndices(indices);
+        mesh.Build();
+
+        Geometry::TriangleMesh quantized_mesh { material };
+        quantized_mesh.SetVertices(positions);
+        quantized_mesh.SetIndices(indices);
+        quantized_mesh.SetBVHFormat(Geometry::BVHFormat::Quantized);
+        quantized_mesh.Build();
+
+        const auto rays = RaysTowardsOrigin(gen, 3.0f, 1.2f);
+        Run(options, "TriangleMesh::Intersect", BATCH_SIZE, 1.0, "rays", [&](uint32_t i) {
+            if (auto hit = mesh.Intersect(rays[i])) g_sink = g_sink + hit->Time();
+        });
+        Run(options, "TriangleMesh::Intersect (quantized)", BATCH_SIZE, 1.0, "rays", [&](uint32_t i) {
+            if (auto hit = quantized_mesh.Intersect(rays[i])) g_sink = g_sink + hit->Time();
+        });
+
+        if (options.filter.empty() || std::string("TriangleMesh::Intersect (quantized)").find(options.filter) != std::string::npos) {
+            std::cout << "  BVH bytes: float " << mesh.AccelerationStructureBytes()
+                      << ", quantized " << quantized_mesh.AccelerationStructureBytes() << '\n';
+        }
+    }
+
+    void BenchCamera(const BenchOptions &options, std::mt19937 &gen) {
+        Scene::Camera camera { glm::vec3(0.0f, 1.0f, 3.0f), glm::vec3(0.0f) };
+        camera.SetImageSize(1920, 1080);
+        camera.Update();
+
+        std::uniform_real_distribution<float> u(0.0f, 1920.0f), v(0.0f, 1080.0f);
+        std::vector<glm::vec2> pixels(BATCH_SIZE);
+        for (auto &pixel : pixels) pixel = { u(gen), v(gen) };
+
+        Run(options, "Camera::GenerateRay", BATCH_SIZE, 1.0, "rays", [&](uint32_t i) {
+            g_sink = g_sink + camera.GenerateRay(pixels[i].x, pixels[i].y).Direction().x;
+        });
+    }
+
+    void BenchDirectIllumination(const BenchOptions &options, std::mt19937 &gen) {
+        // Floor with 16 spheres on it, lit by two point lights
+        auto material = std::make_shared<Materials::Diffuse>(Color(0.8f));
+        Scene::Scene scene;
+        scene.SetCamera(std::make_shared<Scene::Camera>());
+        scene.Add<Geometry::Sphere>(glm::vec3(0.0f, -100.0f, 0.0f), 100.0f, material);
+        for (uint32_t i = 0; i < 16; ++i)
+            scene.Add<Geometry::Sphere>(glm::vec3(float(i % 4) * 2.0f - 3.0f, 0.5f, float(i / 4) * 2.0f - 3.0f), 0.5f, material);
+        scene.AddLight<Scene::PointLight>(glm::vec3(-2.0f, 5.0f, 2.0f), Color(50.0f, 50.0f, 50.0f, 1.0f));
+        scene.AddLight<Scene::PointLight>(glm::vec3(3.0f, 4.0f, -1.0f), Color(30.0f, 30.0f, 30.0f, 1.0f));
+        scene.Build();
+
+        std::uniform_real_distribution<float> coordinate(-4.0f, 4.0f);
+        std::vector<glm::vec3> points(BATCH_SIZE);
+        for (auto &point : points) point = { coordinate(gen), 1e-3f, coordinate(gen) };
+        const glm::vec3 normal { 0.0f, 1.0f, 0.0f };
+
+        Run(options, "Scene::DirectIllumination", BATCH_SIZE, 1.0, "points", [&](uint32_t i) {
+            g_sink = g_sink + scene.DirectIllumination(points[i], normal).r;
+        });
+    }
+
+    void BenchReflectance(const BenchOptions &options, std::mt19937 &gen) {
+        Materials::Dielectric glass { 1.5f };
+
+        std::vector<glm::vec3> directions(BATCH_SIZE), normals(BATCH_SIZE);
+        for (uint32_t i = 0; i < BATCH_SIZE; ++i) {
+            directions[i] = RandomDirection(gen);
+            normals[i] = RandomDirection(gen);
+        }
+
+        Run(options, "Dielectric::ComputeReflectance", BATCH_SIZE, 1.0, "evals", [&](uint32_t i) {
+            g_sink = g_sink + glass.ComputeReflectance(directions[i], normals[i], 1.0f / 1.5f);
+        });
+    }
+
+    void BenchFilm(const BenchOptions &options, std::mt19937 &gen) {
+        constexpr uint32_t SIZE = 1024;
+        Renderer::Film film { SIZE, SIZE, VK_FORMAT_R8G8B8A8_SRGB };
+
+        std::uniform_int_distribution<uint32_t> coordinate(0, SIZE - 1);
+        std::uniform_real_distribution<float> value(0.0f, 1.5f);
+        std::vector<glm::ivec2> pixels(BATCH_SIZE);
+        std::vector<Color> colors(BATCH_SIZE);
+        for (uint32_t i = 0; i < BATCH_SIZE; ++i) {
+            pixels[i] = { int(coordinate(gen)), int(coordinate(gen)) };
+            colors[i] = { value(gen), value(gen), value(gen), 1.0f };
+        }
+
+        Run(options, "Film::AddSample", BATCH_SIZE, 1.0, "samples", [&](uint32_t i) {
+            film.AddSample(pixels[i].x, pixels[i].y, colors[i]);
+        });
+
+        // One sample per tile marks the whole film dirty, so every call resolves all pixels
+        constexpr uint32_t TILES = (SIZE + Renderer::Film::TILE_SIZE - 1) / Renderer::Film::TILE_SIZE;
+        Run(options, "Film::Resolve (1024x1024)", 1, double(SIZE) * SIZE, "pixels", [&](uint32_t) {
+            for (uint32_t ty = 0; ty < TILES; ++ty)
+                for (uint32_t tx = 0; tx < TILES; ++tx)
+                    film.AddSample(tx * Renderer::Film::TILE_SIZE, ty * Renderer::Film::TILE_SIZE, colors[tx]);
+            g_sink = g_sink + float(film.Data()[0]);
+        });
+    }
+
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    std::string valid_usage_str = "\tUsage raytracer_microbench [--min-time ms] [--filter substring]";
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 < argc && std::strcmp(argv[i], "--min-time") == 0) {
+            options.min_seconds = std::strtod(argv[i + 1], nullptr) * 1e-3;
+            i++;
+        } else if (i + 1 < argc && std::strcmp(argv[i], "--filter") == 0) {
+            options.filter = argv[i + 1];
+            i++;
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            std::cerr << valid_usage_str << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        std::mt19937 gen { 1 };
+        BenchSphere(options, gen);
+        BenchTriangleMesh(options, gen);
+        BenchCamera(options, gen);
+        BenchDirectIllumination(options, gen);
+        BenchReflectance(options, gen);
+        BenchFilm(options, gen);
+    } catch (const std::exception &e) {
+        std::cerr << "Uncaught exception: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
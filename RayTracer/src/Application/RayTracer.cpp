@@ -6,33 +6,57 @@
 
 namespace Application {
 
-    RayTracer::RayTracer(uint32_t video_width, uint32_t video_height, uint32_t samples_per_pixel)
-        : m_graphics_backend("Example Window", video_width, video_height)
+    RayTracer::RayTracer(uint32_t video_width, uint32_t video_height, uint32_t samples_per_pixel, bool no_gui, VkFormat headless_format)
+        : m_no_gui(no_gui)
     {
-        VkExtent2D extent = m_graphics_backend.GetWindow().GetFramebufferExtent();
-        VkFormat format = m_graphics_backend.GetVulkanRenderer().SwapChainFormat();
+        VkExtent2D extent { video_width, video_height };
+        VkFormat format = headless_format;
 
+        if (!m_no_gui) {
+            m_graphics_backend = std::make_unique<Backend::GraphicsBackend>("Example Window", video_width, video_height);
+            extent = m_graphics_backend->GetWindow().GetFramebufferExtent();
+            format = m_graphics_backend->GetVulkanRenderer().SwapChainFormat();
+        }
+
+        m_film_extent = extent;
         m_renderer = std::make_unique<Renderer::Renderer>(extent.width, extent.height, format, samples_per_pixel, std::make_unique<Renderer::WhittedTracer>());
+
+        // Nothing waits on a headless frame, so fewer and larger frames cost less overhead
+        if (m_no_gui)
+            m_renderer->SetFrameBudget(Renderer::Renderer::HEADLESS_FRAME_BUDGET_MS);
+    }
+
+    void RayTracer::SetTracePath(const std::string &path) {
+        m_trace_path = path;
+        Utils::Profiler::SetThreadName("Main");
+        Utils::Profiler::EnableTracing();
     }
 
     void RayTracer::Run() {
-        while (!m_graphics_backend.GetWindow().ShouldClose()) {
-            m_graphics_backend.GetWindow().PollEvents();
-            Update();
+        if (m_no_gui) {
+            while (!Update()) {}
+        } else {
+            while (!m_graphics_backend->GetWindow().ShouldClose()) {
+                m_graphics_backend->GetWindow().PollEvents();
+                Update();
+            }
         }
 
         Utils::Profiler::LogSummary();
+        if (!m_trace_path.empty()) {
+            Utils::Profiler::WriteChromeTrace(m_trace_path);
+            std::cout << "Trace written to " << m_trace_path << std::endl;
+        }
     }
     
-    void RayTracer::Update() {
-        auto [width, height] = m_graphics_backend.GetWindow().GetFramebufferExtent();
-        m_scene->GetCamera().SetImageSize(width, height);
+    bool RayTracer::Update() {
+        m_scene->GetCamera().SetImageSize(m_film_extent.width, m_film_extent.height);
         m_scene->GetCamera().Update();
         
         auto [film, render_complete] = m_renderer->RenderToFilm(*m_scene);
 
         if (!m_no_gui) {
-            m_graphics_backend.GetVulkanRenderer().Present(
+            m_graphics_backend->GetVulkanRenderer().Present(
                 film.Data(),
                 film.Width(),
                 film.Height()
@@ -44,6 +68,8 @@ namespace Application {
             std::cout << "Succesfully written to image: " << m_output_path << std::endl;
             m_output_path = "";
         }
+
+        return render_complete;
     }
 
 }
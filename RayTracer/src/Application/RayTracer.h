@@ -3,28 +3,42 @@
 #include "Backend/GraphicsBackend.h"
 #include "Renderer/Renderer.h"
 #include "Scene/Scene.h"
+#include <memory>
 
 namespace Application {
 
     /**
      * @brief Handles the running of main loop and components.
      * It is to be handled by the user
+     *
+     * With `no_gui` set no window, Vulkan instance or swap chain is created: the film is
+     * allocated directly at the requested resolution and format, and `Run` returns as soon
+     * as the render has converged.
      */
     class RayTracer {
     public:
-        RayTracer(uint32_t video_width, uint32_t video_height, uint32_t samples_per_pixel);
+        RayTracer(uint32_t video_width, uint32_t video_height, uint32_t samples_per_pixel,
+                  bool no_gui = false, VkFormat headless_format = VK_FORMAT_R8G8B8A8_SRGB);
         inline void SetOutputPath(const std::string &path) { m_output_path = path; }
-        inline void SetNoGui(bool value) { m_no_gui = value; }
+
+        /** @brief Records every profiled scope and writes them as a Chrome trace to `path` when `Run` returns. */
+        void SetTracePath(const std::string &path);
+        inline void SetSampleOrder(Renderer::SampleOrder order) { m_renderer->SetSampleOrder(order); }
+        inline void SetTracer(std::unique_ptr<Renderer::Tracer> tracer) { m_renderer->SetTracer(std::move(tracer)); }
+        inline void SetAdaptiveSampling(float threshold) { m_renderer->SetAdaptiveSampling(threshold); }
+        inline void SetFrameBudget(double milliseconds) { m_renderer->SetFrameBudget(milliseconds); }
 
         void Run();
-        void SetScene(std::shared_ptr<Scene::Scene> scene) { m_scene = scene; }
+        void SetScene(std::shared_ptr<Scene::Scene> scene) { m_scene = scene; m_scene->Build(&m_renderer->Scheduler()); }
     private:
         std::unique_ptr<Renderer::Renderer> m_renderer;
-        Backend::GraphicsBackend m_graphics_backend;
+        std::unique_ptr<Backend::GraphicsBackend> m_graphics_backend;
         std::shared_ptr<Scene::Scene> m_scene;
+        VkExtent2D m_film_extent {};
     private:
-        void Update();
+        bool Update();
         std::string m_output_path = "";
+        std::string m_trace_path = "";
         bool m_no_gui = false;
     };
 
@@ -1,11 +1,18 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <glm/glm.hpp>
 
 using Color = glm::vec4;
 
 namespace Common {
 
+    /** @brief Relative luminance of a linear Rec. 709 color. */
+    inline float Luminance(const Color &color) {
+        return 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+    }
+
     inline uint8_t LinearColorToByte(float value) {
         value = glm::clamp(value, 0.0f, 1.0f);
         return static_cast<uint8_t>(value * 255.0f + 0.5f);
@@ -18,5 +25,21 @@ namespace Common {
         return static_cast<uint8_t>(value * 255.0f + 0.5f);
     }
 
-}
+    /** @brief Resolution of `SRGBLookupTable`, linear values are quantized to 12 bits. */
+    constexpr uint32_t SRGB_LUT_SIZE = 4096;
 
+    /**
+     * @brief Table mapping a linear value quantized to [0, SRGB_LUT_SIZE) to its sRGB byte, so
+     * that resolving a frame does not pay for a `std::pow` per channel.
+     */
+    inline const std::array<uint8_t, SRGB_LUT_SIZE> &SRGBLookupTable() {
+        static const std::array<uint8_t, SRGB_LUT_SIZE> table = [] {
+            std::array<uint8_t, SRGB_LUT_SIZE> result {};
+            for (uint32_t i = 0; i < SRGB_LUT_SIZE; ++i)
+                result[i] = SRGBColorToByte(static_cast<float>(i) / static_cast<float>(SRGB_LUT_SIZE - 1));
+            return result;
+        }();
+        return table;
+    }
+
+}
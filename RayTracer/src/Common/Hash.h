@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Common {
+
+    /** @brief 32-bit integer finalizer with full avalanche (lowbias32). */
+    inline uint32_t Hash(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    inline uint32_t HashCombine(uint32_t seed, uint32_t value) {
+        return Hash(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+    }
+
+    /**
+     * @brief Stateless pseudo-random permutation of [0, length). Returns the position of
+     * `index` under the permutation selected by `seed` (Kensler, "Correlated Multi-Jittered
+     * Sampling"). Works for any length by cycle-walking inside the next power of two.
+     */
+    inline uint32_t Permute(uint32_t index, uint32_t length, uint32_t seed) {
+        uint32_t mask = length - 1;
+        mask |= mask >> 1;
+        mask |= mask >> 2;
+        mask |= mask >> 4;
+        mask |= mask >> 8;
+        mask |= mask >> 16;
+
+        do {
+            index ^= seed;
+            index *= 0xe170893du;
+            index ^= seed >> 16;
+            index ^= (index & mask) >> 4;
+            index ^= seed >> 8;
+            index *= 0x0929eb3fu;
+            index ^= seed >> 23;
+            index ^= (index & mask) >> 1;
+            index *= 1u | seed >> 27;
+            index *= 0x6935fa69u;
+            index ^= (index & mask) >> 11;
+            index *= 0x74dcb303u;
+            index ^= (index & mask) >> 2;
+            index *= 0x9e501cc3u;
+            index ^= (index & mask) >> 2;
+            index *= 0xc860a3dfu;
+            index &= mask;
+            index ^= index >> 5;
+        } while (index >= length);
+
+        return static_cast<uint32_t>((static_cast<uint64_t>(index) + seed) % length);
+    }
+
+}
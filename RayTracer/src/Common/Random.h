@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Common/Hash.h"
+#include <cstdint>
+
+namespace Common {
+
+    /** @brief PCG-based 32-bit hash (Jarzynski and Olano, "Hash Functions for GPU Rendering"). */
+    inline uint32_t PcgHash(uint32_t x) {
+        uint32_t state = x * 747796405u + 2891336453u;
+        uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        return (word >> 22u) ^ word;
+    }
+
+    /** @brief Maps the upper 24 bits of `bits` to a float in [0, 1). */
+    inline float ToUnitFloat(uint32_t bits) {
+        return float(bits >> 8) * 0x1p-24f;
+    }
+
+    /**
+     * @brief Counter-based random numbers for one camera sample. Dimension d of the sample is a
+     * hash of (seed, pixel, sample index, d), so the numbers do not depend on which thread traces
+     * the sample or when, and any single sample can be replayed by rebuilding its generator.
+     */
+    class SampleRng {
+    public:
+        SampleRng(uint32_t seed, uint32_t pixel, uint32_t sample_index)
+            : m_key(PcgHash(HashCombine(HashCombine(seed, pixel), sample_index)))
+        {}
+
+        /** @brief Value of the given dimension, independent of the generator's position. */
+        inline float Get(uint32_t dimension) const { return ToUnitFloat(PcgHash(m_key + PcgHash(dimension))); }
+
+        /** @brief Value of the next unused dimension. */
+        inline float Next() { return Get(m_dimension++); }
+    private:
+        uint32_t m_key;
+        uint32_t m_dimension = 0;
+    };
+
+}
@@ -1,3 +1,4 @@
 #pragma once
 
 #define UTILS_RunProfile 1
+#define UTILS_RayStats 1
@@ -0,0 +1,35 @@
+#include "Geometry/AABB.h"
+#include <utility>
+
+namespace Geometry {
+
+    float AABB::SurfaceArea() const {
+        if (IsEmpty()) return 0.0f;
+
+        glm::vec3 extent = Extent();
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    int AABB::LargestAxis() const {
+        glm::vec3 extent = Extent();
+        if (extent.x > extent.y && extent.x > extent.z) return 0;
+        return extent.y > extent.z ? 1 : 2;
+    }
+
+    bool AABB::Intersect(const glm::vec3 &origin, const glm::vec3 &inverse_direction, float tmin, float tmax) const {
+        for (int axis = 0; axis < 3; ++axis) {
+            float t_near = (m_min[axis] - origin[axis]) * inverse_direction[axis];
+            float t_far = (m_max[axis] - origin[axis]) * inverse_direction[axis];
+            if (t_near > t_far) std::swap(t_near, t_far);
+
+            // Widen the far plane slightly so that rays grazing a face are not lost to rounding
+            t_far *= 1.0f + 2.0f * 3.0f * std::numeric_limits<float>::epsilon();
+
+            tmin = t_near > tmin ? t_near : tmin;
+            tmax = t_far < tmax ? t_far : tmax;
+            if (tmin > tmax) return false;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Geometry/Ray.h"
+#include <glm/glm.hpp>
+#include <limits>
+
+namespace Geometry {
+
+    /**
+     * @brief Axis-aligned bounding box in world space. A default constructed box is
+     * empty, so it can be grown with `Extend`/`Union` without special casing.
+     */
+    class AABB {
+    public:
+        AABB() = default;
+        AABB(const glm::vec3 &min, const glm::vec3 &max)
+            : m_min(min)
+            , m_max(max)
+        {}
+
+        inline const glm::vec3 &Min() const { return m_min; }
+        inline const glm::vec3 &Max() const { return m_max; }
+        inline glm::vec3 Centroid() const { return 0.5f * (m_min + m_max); }
+        inline glm::vec3 Extent() const { return m_max - m_min; }
+        inline bool IsEmpty() const { return m_min.x > m_max.x || m_min.y > m_max.y || m_min.z > m_max.z; }
+
+        /** @brief Whether `point` lies strictly inside the box, so a box that is flat along an axis contains nothing. */
+        inline bool ContainsStrictly(const glm::vec3 &point) const {
+            return point.x > m_min.x && point.y > m_min.y && point.z > m_min.z
+                && point.x < m_max.x && point.y < m_max.y && point.z < m_max.z;
+        }
+
+        inline void Extend(const glm::vec3 &point) {
+            m_min = glm::min(m_min, point);
+            m_max = glm::max(m_max, point);
+        }
+
+        inline void Extend(const AABB &other) {
+            m_min = glm::min(m_min, other.m_min);
+            m_max = glm::max(m_max, other.m_max);
+        }
+
+        static inline AABB Union(AABB a, const AABB &b) { a.Extend(b); return a; }
+
+        float SurfaceArea() const;
+        int LargestAxis() const;
+
+        /**
+         * @brief Slab test against a ray given by its origin and precomputed inverse direction.
+         * Returns true if the ray overlaps the box somewhere within [tmin, tmax].
+         */
+        bool Intersect(const glm::vec3 &origin, const glm::vec3 &inverse_direction, float tmin, float tmax) const;
+    private:
+        glm::vec3 m_min { std::numeric_limits<float>::infinity() };
+        glm::vec3 m_max { -std::numeric_limits<float>::infinity() };
+    };
+
+}
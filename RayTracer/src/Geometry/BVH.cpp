@@ -0,0 +1,487 @@
+#include "Geometry/BVH.h"
+#include "Platform/TaskScheduler.h"
+#include "Utils/Profiler.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace Geometry {
+
+    namespace {
+        // Relative cost of visiting a node compared to testing a single item
+        constexpr float TRAVERSAL_COST = 0.125f;
+
+        // Past this depth splits fall back to the median so that the depth stays logarithmic
+        constexpr uint32_t SAH_DEPTH_LIMIT = 32;
+
+        constexpr uint32_t GRID_STEPS = 255;
+
+        static_assert(BVH::MAX_LEAF_SIZE <= QuantizedBVH4Node::MAX_LEAF_SIZE, "leaf counts must fit the quantized nodes");
+
+        /**
+         * Grid step that lets `origin + GRID_STEPS * scale` reach past `max`. Targets are widened by an
+         * ulp throughout so that the decoded planes stay conservative even if the multiply-add gets fused.
+         */
+        float GridScale(float origin, float max) {
+            if (max <= origin) return 0.0f;
+
+            const float target = std::nextafter(max, std::numeric_limits<float>::infinity());
+            float scale = (max - origin) / float(GRID_STEPS);
+            while (origin + float(GRID_STEPS) * scale < target)
+                scale = std::nextafter(scale, std::numeric_limits<float>::infinity());
+            return scale;
+        }
+
+        uint8_t QuantizeMin(float value, float origin, float scale) {
+            if (scale == 0.0f) return 0;
+            const float target = std::nextafter(value, -std::numeric_limits<float>::infinity());
+            int q = static_cast<int>(std::clamp(std::floor((value - origin) / scale), 0.0f, float(GRID_STEPS)));
+            while (q > 0 && origin + float(q) * scale > target) q--;
+            return static_cast<uint8_t>(q);
+        }
+
+        uint8_t QuantizeMax(float value, float origin, float scale) {
+            if (scale == 0.0f) return 0;
+            const float target = std::nextafter(value, std::numeric_limits<float>::infinity());
+            int q = static_cast<int>(std::clamp(std::ceil((value - origin) / scale), 0.0f, float(GRID_STEPS)));
+            while (q < int(GRID_STEPS) && origin + float(q) * scale < target) q++;
+            return static_cast<uint8_t>(q);
+        }
+
+        struct ChunkRange {
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        inline uint32_t ChunkCount(uint32_t begin, uint32_t end, uint32_t chunk_size) {
+            return (end - begin + chunk_size - 1) / chunk_size;
+        }
+
+        inline ChunkRange Chunk(uint32_t begin, uint32_t end, uint32_t chunk_size, uint32_t chunk) {
+            const uint32_t chunk_begin = begin + chunk * chunk_size;
+            return { chunk_begin, std::min(end, chunk_begin + chunk_size) };
+        }
+
+        // Runs `task(chunk)` for every chunk, on the scheduler's workers when there is one
+        template <typename ChunkTask>
+        void ForEachChunk(Platform::TaskScheduler *scheduler, uint32_t chunk_count, ChunkTask &&task) {
+            if (scheduler == nullptr) {
+                for (uint32_t chunk = 0; chunk < chunk_count; ++chunk) task(chunk);
+                return;
+            }
+            scheduler->ParallelFor(chunk_count, [&](uint32_t chunk, uint32_t) { task(chunk); });
+        }
+    }
+
+    void BVH::Build(const std::vector<AABB> &item_bounds, BVHFormat format, Platform::TaskScheduler *scheduler) {
+        m_format = format;
+        m_nodes.clear();
+        m_quantized_nodes.clear();
+        m_indices.clear();
+        m_bounds = AABB();
+        if (item_bounds.empty()) return;
+
+        const uint32_t item_count = static_cast<uint32_t>(item_bounds.size());
+        std::vector<BuildItem> items(item_count);
+        std::vector<BuildItem> scratch(item_count >= PARALLEL_BUILD_THRESHOLD ? item_count : 0);
+        BuildContext context { scheduler, items, scratch };
+
+        std::vector<BVHNode> binary;
+        {
+            PROFILE_SCOPE(Scene, "BVH SAH Build");
+            ForEachChunk(scheduler, ChunkCount(0, item_count, PARALLEL_CHUNK_SIZE), [&](uint32_t chunk) {
+                const auto [begin, end] = Chunk(0, item_count, PARALLEL_CHUNK_SIZE, chunk);
+                for (uint32_t i = begin; i < end; ++i)
+                    items[i] = { item_bounds[i], item_bounds[i].Centroid(), i };
+            });
+
+            BuildOutput output;
+            output.nodes.reserve(2 * item_count);
+            output.indices.reserve(item_count);
+            BuildRecursive(context, output, 0, item_count, 0);
+
+            binary = std::move(output.nodes);
+            m_indices = std::move(output.indices);
+            m_bounds = binary[0].bounds;
+        }
+
+        PROFILE_SCOPE(Scene, "BVH Collapse");
+        if (format == BVHFormat::Quantized) {
+            // Items are re-emitted so that the leaf children of every node are consecutive
+            std::vector<uint32_t> indices;
+            indices.reserve(m_indices.size());
+            m_quantized_nodes.reserve(binary.size() / 2 + 1);
+            m_quantized_nodes.emplace_back();
+            CollapseQuantized(binary, 0, 0, indices);
+            m_quantized_nodes.shrink_to_fit();
+            m_indices = std::move(indices);
+        } else {
+            m_nodes.reserve(binary.size() / 2 + 1);
+            Collapse(binary, 0);
+            m_nodes.shrink_to_fit();
+        }
+    }
+
+    size_t BVH::MemoryUsage() const {
+        return m_nodes.capacity() * sizeof(BVH4Node)
+            + m_quantized_nodes.capacity() * sizeof(QuantizedBVH4Node)
+            + m_indices.capacity() * sizeof(uint32_t);
+    }
+
+    uint32_t BVH::MakeLeaf(const BuildContext &context, BuildOutput &output, const AABB &bounds, uint32_t begin, uint32_t end) {
+        uint32_t node_index = static_cast<uint32_t>(output.nodes.size());
+        output.nodes.push_back({ bounds, static_cast<uint32_t>(output.indices.size()), static_cast<uint16_t>(end - begin) });
+        for (uint32_t i = begin; i < end; ++i)
+            output.indices.push_back(context.items[i].index);
+        return node_index;
+    }
+
+    uint32_t BVH::Splice(BuildOutput &output, const BuildOutput &subtree) {
+        const uint32_t node_base = static_cast<uint32_t>(output.nodes.size());
+        const uint32_t index_base = static_cast<uint32_t>(output.indices.size());
+        for (BVHNode node : subtree.nodes) {
+            node.offset += node.count > 0 ? index_base : node_base;
+            output.nodes.push_back(node);
+        }
+        output.indices.insert(output.indices.end(), subtree.indices.begin(), subtree.indices.end());
+        return node_base;
+    }
+
+    uint32_t BVH::GatherChildren(const std::vector<BVHNode> &binary, uint32_t binary_index, uint32_t children[BVH4Node::WIDTH]) const {
+        // Gather up to four children by opening the interior child with the largest surface area,
+        // the one most likely to be hit. A leaf root becomes the only child of the root.
+        uint32_t child_count = 0;
+        if (binary[binary_index].count > 0) {
+            children[child_count++] = binary_index;
+        } else {
+            children[child_count++] = binary_index + 1;
+            children[child_count++] = binary[binary_index].offset;
+        }
+
+        while (child_count < BVH4Node::WIDTH) {
+            int largest = -1;
+            float largest_area = -1.0f;
+            for (uint32_t c = 0; c < child_count; ++c) {
+                const BVHNode &child = binary[children[c]];
+                if (child.count == 0 && child.bounds.SurfaceArea() > largest_area) {
+                    largest = static_cast<int>(c);
+                    largest_area = child.bounds.SurfaceArea();
+                }
+            }
+            if (largest < 0) break;
+
+            const uint32_t opened = children[largest];
+            children[largest] = opened + 1;
+            children[child_count++] = binary[opened].offset;
+        }
+
+        return child_count;
+    }
+
+    uint32_t BVH::Collapse(const std::vector<BVHNode> &binary, uint32_t binary_index) {
+        uint32_t children[BVH4Node::WIDTH];
+        const uint32_t child_count = GatherChildren(binary, binary_index, children);
+
+        const uint32_t node_index = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+        {
+            BVH4Node &node = m_nodes[node_index];
+            node.child_count = static_cast<uint8_t>(child_count);
+            for (uint32_t c = 0; c < BVH4Node::WIDTH; ++c) {
+                // Unused slots are masked off by child_count, zero bounds keep them finite
+                const AABB bounds = c < child_count ? binary[children[c]].bounds : AABB(glm::vec3(0.0f), glm::vec3(0.0f));
+                for (int axis = 0; axis < 3; ++axis) {
+                    node.bounds[0][axis][c] = bounds.Min()[axis];
+                    node.bounds[1][axis][c] = bounds.Max()[axis];
+                }
+                node.offset[c] = 0;
+                node.count[c] = 0;
+            }
+        }
+
+        // Recursion appends nodes and may reallocate, so the node is looked up again for every child
+        for (uint32_t c = 0; c < child_count; ++c) {
+            const BVHNode &child = binary[children[c]];
+            if (child.count > 0) {
+                m_nodes[node_index].offset[c] = child.offset;
+                m_nodes[node_index].count[c] = child.count;
+            } else {
+                const uint32_t child_index = Collapse(binary, children[c]);
+                m_nodes[node_index].offset[c] = child_index;
+            }
+        }
+
+        return node_index;
+    }
+
+    void BVH::CollapseQuantized(const std::vector<BVHNode> &binary, uint32_t binary_index, uint32_t node_index, std::vector<uint32_t> &indices) {
+        uint32_t children[BVH4Node::WIDTH];
+        const uint32_t child_count = GatherChildren(binary, binary_index, children);
+
+        // Interior children get consecutive slots now, their subtrees are appended after them
+        uint32_t interior_count = 0;
+        for (uint32_t c = 0; c < child_count; ++c)
+            if (binary[children[c]].count == 0) interior_count++;
+        const uint32_t first_child = static_cast<uint32_t>(m_quantized_nodes.size());
+        m_quantized_nodes.resize(m_quantized_nodes.size() + interior_count);
+
+        {
+            QuantizedBVH4Node &node = m_quantized_nodes[node_index];
+            const AABB &parent = binary[binary_index].bounds;
+            node.child_count = static_cast<uint8_t>(child_count);
+            node.first_child = first_child;
+            node.first_item = static_cast<uint32_t>(indices.size());
+
+            for (int axis = 0; axis < 3; ++axis) {
+                node.origin[axis] = parent.Min()[axis];
+                node.scale[axis] = GridScale(parent.Min()[axis], parent.Max()[axis]);
+            }
+
+            for (uint32_t c = 0; c < QuantizedBVH4Node::WIDTH; ++c) {
+                node.count[c] = 0;
+                for (int axis = 0; axis < 3; ++axis) {
+                    node.bounds[0][axis][c] = 0;
+                    node.bounds[1][axis][c] = 0;
+                }
+                if (c >= child_count) continue;   // masked off by child_count
+
+                const BVHNode &child = binary[children[c]];
+                for (int axis = 0; axis < 3; ++axis) {
+                    node.bounds[0][axis][c] = QuantizeMin(child.bounds.Min()[axis], node.origin[axis], node.scale[axis]);
+                    node.bounds[1][axis][c] = QuantizeMax(child.bounds.Max()[axis], node.origin[axis], node.scale[axis]);
+                }
+                if (child.count > 0) {
+                    node.count[c] = static_cast<uint8_t>(child.count);
+                    indices.insert(indices.end(), m_indices.begin() + child.offset, m_indices.begin() + child.offset + child.count);
+                }
+            }
+        }
+
+        uint32_t next_child = first_child;
+        for (uint32_t c = 0; c < child_count; ++c) {
+            if (binary[children[c]].count == 0)
+                CollapseQuantized(binary, children[c], next_child++, indices);
+        }
+    }
+
+    void BVH::ComputeBounds(const BuildContext &context, uint32_t begin, uint32_t end, AABB &bounds, AABB &centroid_bounds) {
+        const auto bound_range = [&](uint32_t range_begin, uint32_t range_end, AABB &range_bounds, AABB &range_centroids) {
+            for (uint32_t i = range_begin; i < range_end; ++i) {
+                range_bounds.Extend(context.items[i].bounds);
+                range_centroids.Extend(context.items[i].centroid);
+            }
+        };
+
+        if (end - begin < PARALLEL_BUILD_THRESHOLD) {
+            bound_range(begin, end, bounds, centroid_bounds);
+            return;
+        }
+
+        const uint32_t chunk_count = ChunkCount(begin, end, PARALLEL_CHUNK_SIZE);
+        std::vector<AABB> chunk_bounds(chunk_count), chunk_centroids(chunk_count);
+        ForEachChunk(context.scheduler, chunk_count, [&](uint32_t chunk) {
+            const auto [chunk_begin, chunk_end] = Chunk(begin, end, PARALLEL_CHUNK_SIZE, chunk);
+            bound_range(chunk_begin, chunk_end, chunk_bounds[chunk], chunk_centroids[chunk]);
+        });
+        for (uint32_t chunk = 0; chunk < chunk_count; ++chunk) {
+            bounds.Extend(chunk_bounds[chunk]);
+            centroid_bounds.Extend(chunk_centroids[chunk]);
+        }
+    }
+
+    void BVH::BinItems(const BuildContext &context, uint32_t begin, uint32_t end, const AABB &centroid_bounds, AxisBins &bins) {
+        const glm::vec3 centroid_extent = centroid_bounds.Extent();
+        const auto bin_range = [&](uint32_t range_begin, uint32_t range_end, AxisBins &range_bins) {
+            for (int axis = 0; axis < 3; ++axis) {
+                if (centroid_extent[axis] <= 0.0f) continue;
+
+                const float axis_min = centroid_bounds.Min()[axis];
+                const float bin_scale = BIN_COUNT / centroid_extent[axis];
+                for (uint32_t i = range_begin; i < range_end; ++i) {
+                    const BuildItem &item = context.items[i];
+                    uint32_t b = std::min(BIN_COUNT - 1, static_cast<uint32_t>((item.centroid[axis] - axis_min) * bin_scale));
+                    range_bins[axis][b].count++;
+                    range_bins[axis][b].bounds.Extend(item.bounds);
+                }
+            }
+        };
+
+        if (end - begin < PARALLEL_BUILD_THRESHOLD) {
+            bin_range(begin, end, bins);
+            return;
+        }
+
+        // Bins merge with min/max and integer sums, so the chunking does not change the result
+        const uint32_t chunk_count = ChunkCount(begin, end, PARALLEL_CHUNK_SIZE);
+        std::vector<AxisBins> chunk_bins(chunk_count);
+        ForEachChunk(context.scheduler, chunk_count, [&](uint32_t chunk) {
+            const auto [chunk_begin, chunk_end] = Chunk(begin, end, PARALLEL_CHUNK_SIZE, chunk);
+            bin_range(chunk_begin, chunk_end, chunk_bins[chunk]);
+        });
+        for (const AxisBins &partial : chunk_bins) {
+            for (int axis = 0; axis < 3; ++axis) {
+                for (uint32_t b = 0; b < BIN_COUNT; ++b) {
+                    bins[axis][b].bounds.Extend(partial[axis][b].bounds);
+                    bins[axis][b].count += partial[axis][b].count;
+                }
+            }
+        }
+    }
+
+    template <typename Predicate>
+    uint32_t BVH::Partition(BuildContext &context, uint32_t begin, uint32_t end, Predicate &&goes_left) {
+        std::vector<BuildItem> &items = context.items;
+        if (end - begin < PARALLEL_BUILD_THRESHOLD) {
+            auto middle = std::partition(items.begin() + begin, items.begin() + end, goes_left);
+            return static_cast<uint32_t>(middle - items.begin());
+        }
+
+        // Stable partition through the scratch buffer: count each chunk's left items, then scatter
+        // every chunk to its offsets on both sides and copy the range back
+        const uint32_t chunk_count = ChunkCount(begin, end, PARALLEL_CHUNK_SIZE);
+        std::vector<uint32_t> left_counts(chunk_count);
+        ForEachChunk(context.scheduler, chunk_count, [&](uint32_t chunk) {
+            const auto [chunk_begin, chunk_end] = Chunk(begin, end, PARALLEL_CHUNK_SIZE, chunk);
+            uint32_t left_count = 0;
+            for (uint32_t i = chunk_begin; i < chunk_end; ++i)
+                if (goes_left(items[i])) left_count++;
+            left_counts[chunk] = left_count;
+        });
+
+        std::vector<uint32_t> left_offsets(chunk_count), right_offsets(chunk_count);
+        uint32_t left_total = 0;
+        for (uint32_t chunk = 0; chunk < chunk_count; ++chunk) {
+            left_offsets[chunk] = begin + left_total;
+            left_total += left_counts[chunk];
+        }
+        uint32_t right_offset = begin + left_total;
+        for (uint32_t chunk = 0; chunk < chunk_count; ++chunk) {
+            const auto [chunk_begin, chunk_end] = Chunk(begin, end, PARALLEL_CHUNK_SIZE, chunk);
+            right_offsets[chunk] = right_offset;
+            right_offset += (chunk_end - chunk_begin) - left_counts[chunk];
+        }
+
+        ForEachChunk(context.scheduler, chunk_count, [&](uint32_t chunk) {
+            const auto [chunk_begin, chunk_end] = Chunk(begin, end, PARALLEL_CHUNK_SIZE, chunk);
+            uint32_t left = left_offsets[chunk];
+            uint32_t right = right_offsets[chunk];
+            for (uint32_t i = chunk_begin; i < chunk_end; ++i) {
+                if (goes_left(items[i])) context.scratch[left++] = items[i];
+                else context.scratch[right++] = items[i];
+            }
+        });
+        ForEachChunk(context.scheduler, chunk_count, [&](uint32_t chunk) {
+            const auto [chunk_begin, chunk_end] = Chunk(begin, end, PARALLEL_CHUNK_SIZE, chunk);
+            std::copy(context.scratch.begin() + chunk_begin, context.scratch.begin() + chunk_end, items.begin() + chunk_begin);
+        });
+
+        return begin + left_total;
+    }
+
+    uint32_t BVH::BuildRecursive(BuildContext &context, BuildOutput &output, uint32_t begin, uint32_t end, uint32_t depth) {
+        std::vector<BuildItem> &items = context.items;
+
+        AABB bounds, centroid_bounds;
+        ComputeBounds(context, begin, end, bounds, centroid_bounds);
+
+        const uint32_t count = end - begin;
+        if (count == 1) return MakeLeaf(context, output, bounds, begin, end);
+
+        int axis = centroid_bounds.LargestAxis();
+        glm::vec3 centroid_extent = centroid_bounds.Extent();
+        uint32_t mid = begin;
+
+        if (centroid_extent[axis] <= 0.0f) {
+            // Every centroid coincides, so no plane can separate the items: split them by index
+            // until the leaves are small enough
+            if (count <= MAX_LEAF_SIZE) return MakeLeaf(context, output, bounds, begin, end);
+            mid = begin + count / 2;
+        } else if (depth >= SAH_DEPTH_LIMIT) {
+            mid = begin + count / 2;
+            std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                [axis](const BuildItem &a, const BuildItem &b) { return a.centroid[axis] < b.centroid[axis]; });
+        } else {
+            AxisBins bins {};
+            BinItems(context, begin, end, centroid_bounds, bins);
+
+            float best_cost = std::numeric_limits<float>::infinity();
+            int best_axis = -1;
+            uint32_t best_split = 0;
+
+            for (int split_axis = 0; split_axis < 3; ++split_axis) {
+                if (centroid_extent[split_axis] <= 0.0f) continue;
+                const std::array<Bin, BIN_COUNT> &axis_bins = bins[split_axis];
+
+                // Sweep from the right to gather suffix areas, then from the left to evaluate each plane
+                std::array<float, BIN_COUNT> right_area {};
+                std::array<uint32_t, BIN_COUNT> right_count {};
+                AABB accumulated;
+                uint32_t accumulated_count = 0;
+                for (uint32_t b = BIN_COUNT - 1; b > 0; --b) {
+                    accumulated.Extend(axis_bins[b].bounds);
+                    accumulated_count += axis_bins[b].count;
+                    right_area[b] = accumulated.SurfaceArea();
+                    right_count[b] = accumulated_count;
+                }
+
+                accumulated = AABB();
+                accumulated_count = 0;
+                for (uint32_t b = 0; b < BIN_COUNT - 1; ++b) {
+                    accumulated.Extend(axis_bins[b].bounds);
+                    accumulated_count += axis_bins[b].count;
+                    if (accumulated_count == 0 || right_count[b + 1] == 0) continue;
+
+                    float cost = accumulated_count * accumulated.SurfaceArea() + right_count[b + 1] * right_area[b + 1];
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best_axis = split_axis;
+                        best_split = b;
+                    }
+                }
+            }
+
+            const float leaf_cost = static_cast<float>(count);
+            best_cost = TRAVERSAL_COST + best_cost / bounds.SurfaceArea();
+
+            if (best_axis < 0 || (best_cost >= leaf_cost && count <= MAX_LEAF_SIZE))
+                return MakeLeaf(context, output, bounds, begin, end);
+
+            axis = best_axis;
+            const float axis_min = centroid_bounds.Min()[axis];
+            const float bin_scale = BIN_COUNT / centroid_extent[axis];
+            mid = Partition(context, begin, end, [&](const BuildItem &item) {
+                uint32_t b = std::min(BIN_COUNT - 1, static_cast<uint32_t>((item.centroid[axis] - axis_min) * bin_scale));
+                return b <= best_split;
+            });
+        }
+
+        if (context.scheduler != nullptr && count >= PARALLEL_BUILD_THRESHOLD) {
+            // Both halves are built into outputs of their own, the left one as a task that idle
+            // workers can steal, and spliced in depth-first order so that the layout matches a serial build
+            BuildOutput left, right;
+            Platform::TaskScheduler::TaskGroup group;
+            context.scheduler->Spawn(group, [&](uint32_t) {
+                BuildRecursive(context, left, begin, mid, depth + 1);
+            });
+            BuildRecursive(context, right, mid, end, depth + 1);
+            context.scheduler->Wait(group);
+
+            uint32_t node_index = static_cast<uint32_t>(output.nodes.size());
+            output.nodes.push_back({ bounds, 0, 0 });
+            Splice(output, left);
+            output.nodes[node_index].offset = Splice(output, right);
+            return node_index;
+        }
+
+        uint32_t node_index = static_cast<uint32_t>(output.nodes.size());
+        output.nodes.push_back({ bounds, 0, 0 });
+
+        BuildRecursive(context, output, begin, mid, depth + 1);
+        uint32_t second_child = BuildRecursive(context, output, mid, end, depth + 1);
+        output.nodes[node_index].offset = second_child;
+
+        return node_index;
+    }
+
+}
@@ -0,0 +1,439 @@
+#pragma once
+
+#include "Geometry/AABB.h"
+#include "Geometry/Ray.h"
+#include "Utils/RayStats.h"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Platform { class TaskScheduler; }
+
+namespace Geometry {
+
+    enum class BVHFormat {
+        Float,          // full precision child bounds, 128-byte nodes
+        Quantized       // child bounds quantized to 8 bits inside the node's box, 64-byte nodes
+    };
+
+    /** @brief Node of the binary hierarchy produced by the SAH builder, collapsed into `BVH4Node`s afterwards. */
+    struct BVHNode {
+        AABB bounds;
+        uint32_t offset = 0;    // leaf: first entry in the index array, interior: index of the second child
+        uint16_t count = 0;     // number of items in a leaf, 0 for interior nodes
+    };
+
+    /**
+     * @brief Node of the 4-wide hierarchy that is traversed. The bounds of the children are stored
+     * as structure of arrays, so that a ray is tested against all four with one set of SIMD operations.
+     */
+    struct alignas(64) BVH4Node {
+        static constexpr uint32_t WIDTH = 4;
+
+        float bounds[2][3][WIDTH];      // [min, max][axis][child]
+        uint32_t offset[WIDTH];         // leaf child: first entry in the index array, interior child: node index
+        uint16_t count[WIDTH];          // number of items in a leaf child, 0 for interior children
+        uint8_t child_count = 0;        // children occupy the slots [0, child_count)
+    };
+
+    /**
+     * @brief Compressed 4-wide node for very large meshes. Child bounds are stored as 8-bit
+     * offsets on a grid spanning the node's own box, rounded outwards so that they stay
+     * conservative. Interior children and the items of leaf children are stored consecutively,
+     * so one index of each replaces the per-child offsets.
+     *
+     * Nodes are half the size of `BVH4Node`, but the index array is unchanged, so a whole BVH
+     * shrinks by about 1.9x (524160 to 278464 bytes over an 8192-triangle grid). Traversal pays
+     * for decoding: on that mesh, small enough to stay in cache, a ray takes 10-15% longer than
+     * with float nodes. The format only wins once the float hierarchy no longer fits in cache.
+     */
+    struct alignas(64) QuantizedBVH4Node {
+        static constexpr uint32_t WIDTH = 4;
+        static constexpr uint32_t MAX_LEAF_SIZE = 255;
+
+        float origin[3];                // minimum corner of the node's box
+        float scale[3];                 // size of one grid step per axis
+        uint8_t bounds[2][3][WIDTH];    // [min, max][axis][child] in grid steps
+        uint32_t first_child;           // node index of the first interior child
+        uint32_t first_item;            // index array entry of the first leaf child's first item
+        uint8_t count[WIDTH];           // number of items in a leaf child, 0 for interior children
+        uint8_t child_count = 0;        // children occupy the slots [0, child_count)
+    };
+
+    /**
+     * @brief Bounding volume hierarchy built with the surface area heuristic over a set of
+     * item bounds. The hierarchy only stores item indices, so the same structure is used for
+     * primitives in a scene as well as for triangles inside a mesh.
+     *
+     * The binary SAH tree is collapsed into a 4-wide tree by repeatedly opening the child with
+     * the largest surface area, which halves the traversal depth. Nodes are laid out depth first.
+     * The wide nodes store either float or quantized child bounds, chosen when the BVH is built.
+     *
+     * Given a task scheduler, large ranges are bounded, binned and partitioned in parallel chunks
+     * and their two subtrees are built as separate tasks. The result does not depend on the
+     * scheduler or its number of workers.
+     */
+    class BVH {
+    public:
+        static constexpr uint32_t MAX_LEAF_SIZE = 4;
+        static constexpr uint32_t BIN_COUNT = 12;
+        static constexpr uint32_t MAX_DEPTH = 64;
+
+        /** @brief Rebuilds the hierarchy over `item_bounds`, on the scheduler's workers if one is given. */
+        void Build(const std::vector<AABB> &item_bounds, BVHFormat format = BVHFormat::Float, Platform::TaskScheduler *scheduler = nullptr);
+
+        inline bool IsEmpty() const { return m_nodes.empty() && m_quantized_nodes.empty(); }
+        inline AABB Bounds() const { return m_bounds; }
+        inline BVHFormat Format() const { return m_format; }
+        inline const std::vector<BVH4Node> &Nodes() const { return m_nodes; }
+        inline const std::vector<QuantizedBVH4Node> &QuantizedNodes() const { return m_quantized_nodes; }
+        inline const std::vector<uint32_t> &Indices() const { return m_indices; }
+
+        /** @brief Bytes held by the nodes and the index array. */
+        size_t MemoryUsage() const;
+
+        /**
+         * @brief Closest-hit traversal. Children are visited nearest entry point first.
+         * `intersect_item(index, tmax)` tests a single item, returns whether it was hit and
+         * shrinks `tmax` to the hit time, which culls everything behind it.
+         */
+        template <typename ItemIntersector>
+        bool Intersect(const Ray &ray, float tmin, float tmax, ItemIntersector &&intersect_item) const;
+
+        /**
+         * @brief Any-hit traversal. Returns as soon as `test_item(index)` reports a hit.
+         */
+        template <typename ItemTest>
+        bool IntersectAny(const Ray &ray, float tmin, float tmax, ItemTest &&test_item) const;
+    private:
+        struct BuildItem {
+            AABB bounds;
+            glm::vec3 centroid;
+            uint32_t index;
+        };
+
+        struct Bin {
+            AABB bounds;
+            uint32_t count = 0;
+        };
+
+        using AxisBins = std::array<std::array<Bin, BIN_COUNT>, 3>;
+
+        // Binary nodes and item indices of a subtree, with offsets relative to its own arrays
+        struct BuildOutput {
+            std::vector<BVHNode> nodes;
+            std::vector<uint32_t> indices;
+        };
+
+        struct BuildContext {
+            Platform::TaskScheduler *scheduler;     // nullptr builds on the calling thread
+            std::vector<BuildItem> &items;
+            std::vector<BuildItem> &scratch;        // partition buffer for ranges split in chunks
+        };
+
+        // Ranges at least this large are processed in chunks and fork their subtrees
+        static constexpr uint32_t PARALLEL_BUILD_THRESHOLD = 16384;
+        static constexpr uint32_t PARALLEL_CHUNK_SIZE = 4096;
+
+        // Ray data shared by every node test; `near_side` selects the min (0) or max (1) slab plane per axis
+        struct TraversalRay {
+            glm::vec3 origin;
+            glm::vec3 inverse_direction;
+            uint32_t near_side[3];
+        };
+
+        // A pending subtree: a node when `count` is 0, otherwise a leaf's item range
+        struct StackEntry {
+            uint32_t offset;
+            uint32_t count;
+            float t_near;
+        };
+
+        // Every visited node leaves at most three siblings behind on the stack
+        static constexpr uint32_t STACK_SIZE = 3 * MAX_DEPTH + BVH4Node::WIDTH;
+
+        BVHFormat m_format = BVHFormat::Float;
+        std::vector<BVH4Node> m_nodes {};
+        std::vector<QuantizedBVH4Node> m_quantized_nodes {};
+        std::vector<uint32_t> m_indices {};
+        AABB m_bounds {};
+    private:
+        uint32_t BuildRecursive(BuildContext &context, BuildOutput &output, uint32_t begin, uint32_t end, uint32_t depth);
+        static uint32_t MakeLeaf(const BuildContext &context, BuildOutput &output, const AABB &bounds, uint32_t begin, uint32_t end);
+
+        /** @brief Appends `subtree` to `output`, rebasing its offsets, and returns the index of its root. */
+        static uint32_t Splice(BuildOutput &output, const BuildOutput &subtree);
+
+        static void ComputeBounds(const BuildContext &context, uint32_t begin, uint32_t end, AABB &bounds, AABB &centroid_bounds);
+        static void BinItems(const BuildContext &context, uint32_t begin, uint32_t end, const AABB &centroid_bounds, AxisBins &bins);
+
+        /** @brief Moves the items for which `goes_left` holds to the front of the range and returns the first of the others. */
+        template <typename Predicate>
+        static uint32_t Partition(BuildContext &context, uint32_t begin, uint32_t end, Predicate &&goes_left);
+
+        uint32_t GatherChildren(const std::vector<BVHNode> &binary, uint32_t binary_index, uint32_t children[BVH4Node::WIDTH]) const;
+        uint32_t Collapse(const std::vector<BVHNode> &binary, uint32_t binary_index);
+        void CollapseQuantized(const std::vector<BVHNode> &binary, uint32_t binary_index, uint32_t node_index, std::vector<uint32_t> &indices);
+
+        template <typename Node, typename ItemIntersector>
+        bool IntersectNodes(const std::vector<Node> &nodes, const Ray &ray, float tmin, float tmax, ItemIntersector &&intersect_item) const;
+
+        template <typename Node, typename ItemTest>
+        bool IntersectAnyNodes(const std::vector<Node> &nodes, const Ray &ray, float tmin, float tmax, ItemTest &&test_item) const;
+
+        static TraversalRay MakeTraversalRay(const Ray &ray);
+
+        /** @brief Slab test of the ray against all children. Returns the mask of hit children and their entry times. */
+        static uint32_t IntersectChildren(const BVH4Node &node, const TraversalRay &ray, float tmin, float tmax, float t_near[BVH4Node::WIDTH]);
+        static uint32_t IntersectChildren(const QuantizedBVH4Node &node, const TraversalRay &ray, float tmin, float tmax, float t_near[BVH4Node::WIDTH]);
+
+        /** @brief Where each child slot's subtree or item range starts: a node index for interior children, an index array entry for leaves. */
+        static void ChildOffsets(const BVH4Node &node, uint32_t offsets[BVH4Node::WIDTH]);
+        static void ChildOffsets(const QuantizedBVH4Node &node, uint32_t offsets[BVH4Node::WIDTH]);
+    };
+
+    inline BVH::TraversalRay BVH::MakeTraversalRay(const Ray &ray) {
+        TraversalRay result { ray.Origin(), 1.0f / ray.Direction(), {} };
+        for (int axis = 0; axis < 3; ++axis)
+            result.near_side[axis] = result.inverse_direction[axis] < 0.0f ? 1 : 0;
+        return result;
+    }
+
+    inline uint32_t BVH::IntersectChildren(const BVH4Node &node, const TraversalRay &ray, float tmin, float tmax, float t_near[BVH4Node::WIDTH]) {
+        // Widen the far plane slightly so that rays grazing a face are not lost to rounding, as in AABB::Intersect
+        constexpr float FAR_SCALE = 1.0f + 2.0f * 3.0f * std::numeric_limits<float>::epsilon();
+        const uint32_t used = (1u << node.child_count) - 1;
+
+#if defined(__SSE2__)
+        __m128 near_time = _mm_set1_ps(tmin);
+        __m128 far_time = _mm_set1_ps(tmax);
+        const __m128 far_scale = _mm_set1_ps(FAR_SCALE);
+
+        for (int axis = 0; axis < 3; ++axis) {
+            const __m128 origin = _mm_set1_ps(ray.origin[axis]);
+            const __m128 inverse_direction = _mm_set1_ps(ray.inverse_direction[axis]);
+            const uint32_t near_side = ray.near_side[axis];
+
+            __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[near_side][axis]), origin), inverse_direction);
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[1 - near_side][axis]), origin), inverse_direction);
+
+            // max/min return their second operand for NaN (an axis-parallel ray starting on a slab plane),
+            // which keeps the interval from the other axes
+            near_time = _mm_max_ps(t0, near_time);
+            far_time = _mm_min_ps(_mm_mul_ps(t1, far_scale), far_time);
+        }
+
+        _mm_storeu_ps(t_near, near_time);
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(near_time, far_time))) & used;
+#else
+        uint32_t mask = 0;
+        for (uint32_t child = 0; child < BVH4Node::WIDTH; ++child) {
+            float near_time = tmin;
+            float far_time = tmax;
+            for (int axis = 0; axis < 3; ++axis) {
+                const uint32_t near_side = ray.near_side[axis];
+                float t0 = (node.bounds[near_side][axis][child] - ray.origin[axis]) * ray.inverse_direction[axis];
+                float t1 = (node.bounds[1 - near_side][axis][child] - ray.origin[axis]) * ray.inverse_direction[axis] * FAR_SCALE;
+                near_time = t0 > near_time ? t0 : near_time;
+                far_time = t1 < far_time ? t1 : far_time;
+            }
+            t_near[child] = near_time;
+            if (near_time <= far_time) mask |= 1u << child;
+        }
+        return mask & used;
+#endif
+    }
+
+    inline uint32_t BVH::IntersectChildren(const QuantizedBVH4Node &node, const TraversalRay &ray, float tmin, float tmax, float t_near[BVH4Node::WIDTH]) {
+        constexpr float FAR_SCALE = 1.0f + 2.0f * 3.0f * std::numeric_limits<float>::epsilon();
+        const uint32_t used = (1u << node.child_count) - 1;
+
+#if defined(__SSE2__)
+        // Widens four grid coordinates to floats
+        const auto load_grid = [](const uint8_t grid[BVH4Node::WIDTH]) {
+            int32_t packed;
+            std::memcpy(&packed, grid, sizeof(packed));
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i bytes = _mm_cvtsi32_si128(packed);
+            return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+        };
+
+        __m128 near_time = _mm_set1_ps(tmin);
+        __m128 far_time = _mm_set1_ps(tmax);
+        const __m128 far_scale = _mm_set1_ps(FAR_SCALE);
+
+        for (int axis = 0; axis < 3; ++axis) {
+            const __m128 inverse_direction = _mm_set1_ps(ray.inverse_direction[axis]);
+            const __m128 grid_offset = _mm_set1_ps(node.origin[axis] - ray.origin[axis]);
+            const __m128 grid_scale = _mm_set1_ps(node.scale[axis]);
+            const uint32_t near_side = ray.near_side[axis];
+
+            // Planes are decoded relative to the ray origin before the division by the direction,
+            // which keeps the NaN behaviour of the float nodes
+            __m128 t0 = _mm_mul_ps(_mm_add_ps(grid_offset, _mm_mul_ps(load_grid(node.bounds[near_side][axis]), grid_scale)), inverse_direction);
+            __m128 t1 = _mm_mul_ps(_mm_add_ps(grid_offset, _mm_mul_ps(load_grid(node.bounds[1 - near_side][axis]), grid_scale)), inverse_direction);
+
+            near_time = _mm_max_ps(t0, near_time);
+            far_time = _mm_min_ps(_mm_mul_ps(t1, far_scale), far_time);
+        }
+
+        _mm_storeu_ps(t_near, near_time);
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(near_time, far_time))) & used;
+#else
+        float grid_offset[3];
+        for (int axis = 0; axis < 3; ++axis)
+            grid_offset[axis] = node.origin[axis] - ray.origin[axis];
+
+        uint32_t mask = 0;
+        for (uint32_t child = 0; child < BVH4Node::WIDTH; ++child) {
+            float near_time = tmin;
+            float far_time = tmax;
+            for (int axis = 0; axis < 3; ++axis) {
+                const uint32_t near_side = ray.near_side[axis];
+                float t0 = (grid_offset[axis] + float(node.bounds[near_side][axis][child]) * node.scale[axis]) * ray.inverse_direction[axis];
+                float t1 = (grid_offset[axis] + float(node.bounds[1 - near_side][axis][child]) * node.scale[axis]) * ray.inverse_direction[axis] * FAR_SCALE;
+                near_time = t0 > near_time ? t0 : near_time;
+                far_time = t1 < far_time ? t1 : far_time;
+            }
+            t_near[child] = near_time;
+            if (near_time <= far_time) mask |= 1u << child;
+        }
+        return mask & used;
+#endif
+    }
+
+    inline void BVH::ChildOffsets(const BVH4Node &node, uint32_t offsets[BVH4Node::WIDTH]) {
+        for (uint32_t child = 0; child < BVH4Node::WIDTH; ++child)
+            offsets[child] = node.offset[child];
+    }
+
+    inline void BVH::ChildOffsets(const QuantizedBVH4Node &node, uint32_t offsets[BVH4Node::WIDTH]) {
+        // One pass over the slots instead of a prefix count per hit child; unused slots get offsets that are never read
+        uint32_t next_child = node.first_child;
+        uint32_t next_item = node.first_item;
+        for (uint32_t child = 0; child < BVH4Node::WIDTH; ++child) {
+            const uint32_t count = node.count[child];
+            offsets[child] = count == 0 ? next_child : next_item;
+            next_child += count == 0 ? 1 : 0;
+            next_item += count;
+        }
+    }
+
+    template <typename ItemIntersector>
+    bool BVH::Intersect(const Ray &ray, float tmin, float tmax, ItemIntersector &&intersect_item) const {
+        if (m_format == BVHFormat::Quantized)
+            return IntersectNodes(m_quantized_nodes, ray, tmin, tmax, intersect_item);
+        return IntersectNodes(m_nodes, ray, tmin, tmax, intersect_item);
+    }
+
+    template <typename ItemTest>
+    bool BVH::IntersectAny(const Ray &ray, float tmin, float tmax, ItemTest &&test_item) const {
+        if (m_format == BVHFormat::Quantized)
+            return IntersectAnyNodes(m_quantized_nodes, ray, tmin, tmax, test_item);
+        return IntersectAnyNodes(m_nodes, ray, tmin, tmax, test_item);
+    }
+
+    template <typename Node, typename ItemIntersector>
+    bool BVH::IntersectNodes(const std::vector<Node> &nodes, const Ray &ray, float tmin, float tmax, ItemIntersector &&intersect_item) const {
+        if (nodes.empty()) return false;
+
+        const TraversalRay traversal_ray = MakeTraversalRay(ray);
+
+        StackEntry stack[STACK_SIZE];
+        uint32_t stack_size = 0;
+        stack[stack_size++] = { 0, 0, tmin };
+        uint32_t visited = 0;
+        bool hit = false;
+
+        while (stack_size > 0) {
+            const StackEntry entry = stack[--stack_size];
+            if (entry.t_near > tmax)
+                continue;   // a hit found after the entry was pushed lies in front of it
+
+            if (entry.count > 0) {
+                for (uint32_t i = entry.offset; i < entry.offset + entry.count; ++i) {
+                    if (intersect_item(m_indices[i], tmax))
+                        hit = true;
+                }
+                continue;
+            }
+
+            const Node &node = nodes[entry.offset];
+            ++visited;
+            float t_near[BVH4Node::WIDTH];
+            uint32_t mask = IntersectChildren(node, traversal_ray, tmin, tmax, t_near);
+            if (mask == 0) continue;
+            uint32_t offsets[BVH4Node::WIDTH];
+            ChildOffsets(node, offsets);
+
+            // Insert the hit children sorted far to near, so that the nearest one is popped first
+            const uint32_t first = stack_size;
+            while (mask != 0) {
+                const uint32_t child = static_cast<uint32_t>(std::countr_zero(mask));
+                mask &= mask - 1;
+
+                const StackEntry child_entry { offsets[child], node.count[child], t_near[child] };
+                uint32_t slot = stack_size++;
+                while (slot > first && stack[slot - 1].t_near < child_entry.t_near) {
+                    stack[slot] = stack[slot - 1];
+                    --slot;
+                }
+                stack[slot] = child_entry;
+            }
+        }
+
+        RAY_STATS_ADD(box_tests, visited);
+        return hit;
+    }
+
+    template <typename Node, typename ItemTest>
+    bool BVH::IntersectAnyNodes(const std::vector<Node> &nodes, const Ray &ray, float tmin, float tmax, ItemTest &&test_item) const {
+        if (nodes.empty()) return false;
+
+        const TraversalRay traversal_ray = MakeTraversalRay(ray);
+
+        StackEntry stack[STACK_SIZE];
+        uint32_t stack_size = 0;
+        stack[stack_size++] = { 0, 0, tmin };
+        uint32_t visited = 0;
+
+        while (stack_size > 0) {
+            const StackEntry entry = stack[--stack_size];
+
+            if (entry.count > 0) {
+                for (uint32_t i = entry.offset; i < entry.offset + entry.count; ++i) {
+                    if (test_item(m_indices[i])) {
+                        RAY_STATS_ADD(box_tests, visited);
+                        return true;
+                    }
+                }
+                continue;
+            }
+
+            const Node &node = nodes[entry.offset];
+            ++visited;
+            float t_near[BVH4Node::WIDTH];
+            uint32_t mask = IntersectChildren(node, traversal_ray, tmin, tmax, t_near);
+            if (mask == 0) continue;
+            uint32_t offsets[BVH4Node::WIDTH];
+            ChildOffsets(node, offsets);
+
+            while (mask != 0) {
+                const uint32_t child = static_cast<uint32_t>(std::countr_zero(mask));
+                mask &= mask - 1;
+                stack[stack_size++] = { offsets[child], node.count[child], t_near[child] };
+            }
+        }
+
+        RAY_STATS_ADD(box_tests, visited);
+        return false;
+    }
+
+}
@@ -1,35 +1,151 @@
 #include "Primitive.h"
+#include "Platform/TaskScheduler.h"
+#include "Utils/Profiler.h"
+#include "Utils/RayStats.h"
+#include <cassert>
+#include <cmath>
+#include <limits>
 
 namespace Geometry {
+    namespace {
+        // Past an interface the next search starts this far along the ray, matching the offset of secondary rays
+        constexpr float INTERFACE_OFFSET = 1e-4f;
+
+        /**
+         * @brief Shadow transmittance of one translucent primitive along the ray in [tmin, tmax]. Every
+         * interface crossed passes a fraction of the light, and the medium absorbs along each chord from
+         * an entry to the following exit. Front faces are entries, so surfaces are taken to be closed and
+         * wound outwards, as `Dielectric::Scatter` assumes too.
+         *
+         * An exit without an entry before it means the segment starts inside, and an entry without an exit
+         * after it that it ends inside. Either is only believed when that end of the segment lies strictly
+         * inside the primitive's bounds, which keeps a flat open sheet such as a lone triangle from
+         * absorbing all the way to the shaded point or to the light.
+         */
+        float TranslucentTransmittance(const Primitive &primitive, const Ray &ray, float tmin, float tmax) {
+            float transmittance = 1.0f;
+            float entry = tmin;
+            bool inside = false;
+            bool first_hit = true;
+
+            float t = tmin;
+            while (auto intersection = primitive.Intersect(ray, t, tmax)) {
+                const Materials::Material *material = intersection->Material();
+                transmittance *= material->ShadowTransmittance(*intersection, ray);
+                if (intersection->IsFrontFace()) {
+                    inside = true;
+                    entry = intersection->Time();
+                } else {
+                    if (inside || (first_hit && primitive.Bounds().ContainsStrictly(ray.Origin() + tmin * ray.Direction())))
+                        transmittance *= material->MediumTransmittance(intersection->Time() - entry);
+                    inside = false;
+                }
+                if (transmittance <= 0.0f) return 0.0f;
+
+                first_hit = false;
+                // nextafter keeps the walk moving where the offset is below the float spacing at t
+                t = std::nextafter(intersection->Time() + INTERFACE_OFFSET, std::numeric_limits<float>::infinity());
+            }
+
+            if (inside && std::isfinite(tmax) && primitive.Bounds().ContainsStrictly(ray.Origin() + tmax * ray.Direction()))
+                transmittance *= primitive.Material()->MediumTransmittance(tmax - entry);
+            return transmittance;
+        }
+    }
+
     Primitive::Primitive(std::shared_ptr<Materials::Material> material)
         : m_material(material)
     {}
 
     PrimitiveList::PrimitiveList() {}
 
+    void PrimitiveList::Build(Platform::TaskScheduler *scheduler) {
+        PROFILE_SCOPE(Scene, "BVH Build");
+
+        const uint32_t count = static_cast<uint32_t>(m_data.size());
+        if (scheduler != nullptr) {
+            scheduler->ParallelFor(count, [&](uint32_t index, uint32_t) { m_data[index]->Build(scheduler); });
+        } else {
+            for (const auto &primitive : m_data)
+                primitive->Build();
+        }
+
+        std::vector<AABB> bounds;
+        bounds.reserve(m_data.size());
+        m_opaque.clear();
+        m_has_translucent = false;
+        for (const auto &primitive : m_data) {
+            bounds.push_back(primitive->Bounds());
+            m_opaque.push_back(primitive->Material() == nullptr || primitive->Material()->IsOpaque());
+            m_has_translucent |= !m_opaque.back();
+        }
+
+        m_bvh.Build(bounds, BVHFormat::Float, scheduler);
+    }
+
+    size_t PrimitiveList::AccelerationStructureBytes() const {
+        size_t bytes = m_bvh.MemoryUsage();
+        for (const auto &primitive : m_data)
+            bytes += primitive->AccelerationStructureBytes();
+        return bytes;
+    }
+
     std::optional<Intersection> PrimitiveList::IntersectNearest(const Ray &ray, float tmin, float tmax) const {
-        float min_time = std::numeric_limits<float>::infinity();
+        assert(IsBuilt() && "PrimitiveList::Build must be called after the last Add");
         std::optional<Intersection> result = std::nullopt;
-        
-        for (const auto &primitive : m_data) {
-            if (auto intersection = primitive->Intersect(ray, tmin, tmax); intersection != std::nullopt) {
-                if (intersection->Time() < min_time) {
-                    min_time = intersection->Time();
-                    result = intersection;
-                }
+
+        m_bvh.Intersect(ray, tmin, tmax, [&](uint32_t index, float &closest) {
+            RAY_STATS_INC(primitive_tests);
+            if (auto intersection = m_data[index]->Intersect(ray, tmin, closest); intersection != std::nullopt) {
+                closest = intersection->Time();
+                result = intersection;
+                return true;
             }
-        }
+            return false;
+        });
 
         return result;
     }
 
     std::optional<Intersection> PrimitiveList::IntersectAny(const Ray &ray, float tmin, float tmax) const {
-        for (const auto &primitive : m_data) {
-            if (auto intersection = primitive->Intersect(ray, tmin, tmax); intersection != std::nullopt) {
-                return intersection;
+        assert(IsBuilt() && "PrimitiveList::Build must be called after the last Add");
+        std::optional<Intersection> result = std::nullopt;
+
+        m_bvh.IntersectAny(ray, tmin, tmax, [&](uint32_t index) {
+            RAY_STATS_INC(primitive_tests);
+            result = m_data[index]->Intersect(ray, tmin, tmax);
+            return result != std::nullopt;
+        });
+
+        return result;
+    }
+
+    bool PrimitiveList::Occluded(const Ray &ray, float tmin, float tmax) const {
+        assert(IsBuilt() && "PrimitiveList::Build must be called after the last Add");
+        return m_bvh.IntersectAny(ray, tmin, tmax, [&](uint32_t index) {
+            if (!m_opaque[index]) return false;
+            RAY_STATS_INC(primitive_tests);
+            return m_data[index]->Occluded(ray, tmin, tmax);
+        });
+    }
+
+    float PrimitiveList::Transmittance(const Ray &ray, float tmin, float tmax) const {
+        assert(IsBuilt() && "PrimitiveList::Build must be called after the last Add");
+        float transmittance = 1.0f;
+
+        // Every primitive sits in exactly one leaf, so each one is walked at most once
+        m_bvh.IntersectAny(ray, tmin, tmax, [&](uint32_t index) {
+            RAY_STATS_INC(primitive_tests);
+            if (m_opaque[index]) {
+                if (!m_data[index]->Occluded(ray, tmin, tmax)) return false;
+                transmittance = 0.0f;
+                return true;
             }
-        }
 
-        return std::nullopt;
+            transmittance *= TranslucentTransmittance(*m_data[index], ray, tmin, tmax);
+            return transmittance <= 0.0f;
+        });
+
+        return transmittance;
     }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Geometry/AABB.h"
+#include "Geometry/BVH.h"
 #include "Geometry/Intersections.h"
 #include "Geometry/Ray.h"
 #include "Materials/Material.h"
@@ -14,6 +16,20 @@ namespace Geometry {
         Primitive(std::shared_ptr<Materials::Material> material);
         virtual ~Primitive() = default;
         virtual std::optional<Intersection> Intersect(const Ray &ray, float tmin, float tmax) const = 0;
+
+        /** @brief Whether the ray hits the primitive anywhere in [tmin, tmax]. Builds no hit record. */
+        virtual bool Occluded(const Ray &ray, float tmin, float tmax) const = 0;
+
+        /** @brief World-space bounds used to place the primitive in the scene's BVH. */
+        virtual AABB Bounds() const = 0;
+
+        /** @brief Prepares any per-primitive acceleration data. Called by `PrimitiveList::Build`, possibly on a worker. */
+        virtual void Build(Platform::TaskScheduler *scheduler = nullptr) {}
+
+        /** @brief Bytes held by the per-primitive acceleration data. */
+        virtual size_t AccelerationStructureBytes() const { return 0; }
+
+        inline const Materials::Material *Material() const { return m_material.get(); }
     protected:
         std::shared_ptr<Materials::Material> m_material;
     };
@@ -34,6 +50,13 @@ namespace Geometry {
             m_data.push_back(std::make_unique<T>(std::forward<Args>(args)...));
         }
 
+        /**
+         * @brief Builds the acceleration structure over the current primitives. Must be called
+         * after the last `Add` and before the list is intersected. With a scheduler the primitives
+         * and the BVHs are built on its workers.
+         */
+        void Build(Platform::TaskScheduler *scheduler = nullptr);
+
         std::optional<Intersection> IntersectNearest(
             const Ray &ray, 
             float tmin = 0,
@@ -43,8 +66,35 @@ namespace Geometry {
             const Ray &ray, 
             float tmin = 0,
             float tmax = std::numeric_limits<float>::infinity()) const;
+
+        /**
+         * @brief Shadow query: whether an opaque primitive blocks the ray in [tmin, tmax]. Stops at
+         * the first such hit and skips translucent primitives, which makes it the complete answer
+         * only when `HasTranslucentPrimitives` is false; otherwise use `Transmittance`.
+         */
+        bool Occluded(const Ray &ray, float tmin, float tmax) const;
+
+        /**
+         * @brief Fraction of light that travels along the ray through [tmin, tmax]: 0 as soon as
+         * anything opaque is hit, otherwise the product over every translucent primitive of the
+         * shadow transmittance at each interface crossed and the medium transmittance along each
+         * stretch inside it. Traversal stops once nothing is left to attenuate.
+         */
+        float Transmittance(const Ray &ray, float tmin, float tmax) const;
+
+        /** @brief Whether any primitive has a material that is not opaque, valid after `Build`. */
+        inline bool HasTranslucentPrimitives() const { return m_has_translucent; }
+
+        /** @brief Bytes held by the list's BVH and the acceleration data of every primitive. */
+        size_t AccelerationStructureBytes() const;
     private:
         std::vector<std::unique_ptr<Primitive>> m_data;
+        std::vector<uint8_t> m_opaque;      // per primitive, cached so that shadow rays skip the virtual call
+        bool m_has_translucent = false;
+        BVH m_bvh;
+    private:
+        /** @brief Whether the BVH covers every primitive, i.e. `Build` ran after the last `Add`. */
+        inline bool IsBuilt() const { return m_bvh.Indices().size() == m_data.size(); }
     };
 
 }
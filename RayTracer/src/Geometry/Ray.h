@@ -6,6 +6,7 @@ namespace Geometry {
     
     class Ray {
     public:
+        Ray() = default;
         Ray(const glm::vec3 &origin, const glm::vec3 &direction);
         const glm::vec3 &Origin() const { return m_origin; }
         const glm::vec3 &Direction() const { return m_direction; }
@@ -51,4 +51,26 @@ namespace Geometry {
         return Intersection(ray, point, normal, uv, time, m_material.get());
     }
 
+    bool Sphere::Occluded(const Ray &ray, float tmin, float tmax) const {
+        glm::vec3 offset = ray.Origin() - m_center;
+
+        float a = glm::dot(ray.Direction(), ray.Direction());
+        float b = glm::dot(ray.Direction(), offset);
+        float c = glm::dot(offset, offset) - m_radius * m_radius;
+
+        float discriminant = b * b - a * c;
+        if (discriminant < 0)
+            return false;
+
+        float sqrt_discriminant = std::sqrt(discriminant);
+        float near_time = (-b - sqrt_discriminant) / a;
+        float far_time = (-b + sqrt_discriminant) / a;
+        return (near_time >= tmin && near_time <= tmax) || (far_time >= tmin && far_time <= tmax);
+    }
+
+    AABB Sphere::Bounds() const {
+        glm::vec3 extent { static_cast<float>(m_radius) };
+        return { m_center - extent, m_center + extent };
+    }
+
 }
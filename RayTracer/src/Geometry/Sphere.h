@@ -16,6 +16,8 @@ namespace Geometry {
             const Ray &ray,
             float tmin = 0,
             float tmax = std::numeric_limits<float>::infinity()) const override;
+        virtual bool Occluded(const Ray &ray, float tmin, float tmax) const override;
+        virtual AABB Bounds() const override;
     private:
         glm::vec3 m_center;
         double m_radius;
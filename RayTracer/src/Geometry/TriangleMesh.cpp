@@ -1,5 +1,7 @@
 #include "Geometry/TriangleMesh.h"
 #include "Geometry/Intersections.h"
+#include "Utils/Profiler.h"
+#include "Utils/RayStats.h"
 #include <optional>
 
 namespace Geometry {
@@ -8,68 +10,114 @@ namespace Geometry {
         : Primitive(material)
     {}
 
-    std::optional<Intersection> TriangleMesh::Intersect(const Ray &ray, float tmin, float tmax) const {
+    void TriangleMesh::Build(Platform::TaskScheduler *scheduler) {
+        PROFILE_SCOPE(Scene, "Mesh BVH Build");
         assert(m_indices.size() % 3 == 0);
 
-        std::optional<Intersection> closest_hit;
+        std::vector<AABB> triangle_bounds;
+        triangle_bounds.reserve(TriangleCount());
+        for (uint32_t i = 0; i < m_indices.size(); i += 3) {
+            AABB bounds;
+            bounds.Extend(m_positions[m_indices[i + 0]]);
+            bounds.Extend(m_positions[m_indices[i + 1]]);
+            bounds.Extend(m_positions[m_indices[i + 2]]);
+            triangle_bounds.push_back(bounds);
+        }
+
+        m_bvh.Build(triangle_bounds, m_bvh_format, scheduler);
+    }
+
+    bool TriangleMesh::IntersectTriangle(const Ray &ray, uint32_t triangle, float tmin, float tmax, float &time, float &u, float &v) const {
+        RAY_STATS_INC(triangle_tests);
+
+        // Möller-Trumbore algorithm
+        const glm::vec3 &v0 = m_positions[m_indices[3 * triangle + 0]];
+        const glm::vec3 &v1 = m_positions[m_indices[3 * triangle + 1]];
+        const glm::vec3 &v2 = m_positions[m_indices[3 * triangle + 2]];
+
+        glm::vec3 edge1 = v1 - v0;
+        glm::vec3 edge2 = v2 - v0;
+
+        glm::vec3 direction_cross_edge2 = glm::cross(ray.Direction(), edge2);
+        float det = glm::dot(edge1, direction_cross_edge2);
+        if (std::fabs(det) < 1e-8)
+            return false;
+
+        float inverse_det = 1.0f / det;
+        glm::vec3 tvec = ray.Origin() - v0;
+        u = glm::dot(tvec, direction_cross_edge2) * inverse_det;
+        if (u < 0.0f || u > 1.0f) 
+            return false;
+
+        glm::vec3 qvec = glm::cross(tvec, edge1);
+        v = glm::dot(ray.Direction(), qvec) * inverse_det;
+        if (v < 0.0f || (u + v) > 1.0f) 
+            return false;
+
+        time = glm::dot(edge2, qvec) * inverse_det;
+        return time >= tmin && time <= tmax;
+    }
+
+    std::optional<Intersection> TriangleMesh::Intersect(const Ray &ray, float tmin, float tmax) const {
+        uint32_t best_triangle = 0;
         float best_time = tmax;
+        float best_u = 0.0f, best_v = 0.0f;
 
-        for (uint32_t i = 0; i < m_indices.size(); i += 3) {
-            uint32_t i0 = m_indices[i + 0];
-            uint32_t i1 = m_indices[i + 1];
-            uint32_t i2 = m_indices[i + 2];
-
-            // Möller-Trumbore algorithm
-            const glm::vec3 &v0 = m_positions[i0];
-            const glm::vec3 &v1 = m_positions[i1];
-            const glm::vec3 &v2 = m_positions[i2];
-
-            glm::vec3 edge1 = v1 - v0;
-            glm::vec3 edge2 = v2 - v0;
-
-            glm::vec3 direction_cross_edge2 = glm::cross(ray.Direction(), edge2);
-            float det = glm::dot(edge1, direction_cross_edge2);
-            if (std::fabs(det) < 1e-8)
-                continue;
-
-            float inverse_det = 1.0f / det;
-            glm::vec3 tvec = ray.Origin() - v0;
-            float u = glm::dot(tvec, direction_cross_edge2) * inverse_det;
-            if (u < 0.0f || u > 1.0f) 
-                continue;
-
-            glm::vec3 qvec = glm::cross(tvec, edge1);
-            float v = glm::dot(ray.Direction(), qvec) * inverse_det;
-            if (v < 0.0f || (u + v) > 1.0f) 
-                continue;
-
-            float t = glm::dot(edge2, qvec) * inverse_det;
-            if (t < tmin || t > best_time) 
-                continue;
-
-            best_time = t;
-            glm::vec3 hit_position = ray.Origin() + ray.Direction() * t;
-
-            glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
-            if (glm::dot(normal, ray.Direction()) > 0.0f)
-                normal = -normal;
-            
-            glm::vec2 uv { 0.0f };
-            if (m_texture_coords.size() > 0) {
-                assert(m_texture_coords.size() == m_positions.size());
-                uv = Interpolate<glm::vec2>(u, v, m_texture_coords[i0], m_texture_coords[i1], m_texture_coords[i2]);
-            }
-
-            closest_hit = Intersection{
-                ray,
-                hit_position,
-                normal,
-                uv,
-                t,
-                m_material.get()
-            };
+        bool hit = m_bvh.Intersect(ray, tmin, tmax, [&](uint32_t triangle, float &closest) {
+            float time, u, v;
+            if (!IntersectTriangle(ray, triangle, tmin, closest, time, u, v))
+                return false;
+
+            closest = best_time = time;
+            best_triangle = triangle;
+            best_u = u;
+            best_v = v;
+            return true;
+        });
+
+        if (!hit) return std::nullopt;
+
+        // Only the closest triangle pays for the hit record
+        uint32_t i0 = m_indices[3 * best_triangle + 0];
+        uint32_t i1 = m_indices[3 * best_triangle + 1];
+        uint32_t i2 = m_indices[3 * best_triangle + 2];
+
+        glm::vec3 edge1 = m_positions[i1] - m_positions[i0];
+        glm::vec3 edge2 = m_positions[i2] - m_positions[i0];
+        glm::vec3 hit_position = ray.Origin() + ray.Direction() * best_time;
+
+        // Passed unflipped: Intersection tells front from back faces by the winding before it faces the normal to the ray
+        glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
+
+        glm::vec2 uv { 0.0f };
+        if (m_texture_coords.size() > 0) {
+            assert(m_texture_coords.size() == m_positions.size());
+            uv = Interpolate<glm::vec2>(best_u, best_v, m_texture_coords[i0], m_texture_coords[i1], m_texture_coords[i2]);
         }
 
-        return closest_hit;
+        return Intersection{
+            ray,
+            hit_position,
+            normal,
+            uv,
+            best_time,
+            m_material.get()
+        };
+    }
+
+    bool TriangleMesh::Occluded(const Ray &ray, float tmin, float tmax) const {
+        return m_bvh.IntersectAny(ray, tmin, tmax, [&](uint32_t triangle) {
+            float time, u, v;
+            return IntersectTriangle(ray, triangle, tmin, tmax, time, u, v);
+        });
+    }
+
+    AABB TriangleMesh::Bounds() const {
+        if (!m_bvh.IsEmpty()) return m_bvh.Bounds();
+
+        AABB bounds;
+        for (uint32_t index : m_indices)
+            bounds.Extend(m_positions[index]);
+        return bounds;
     }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Geometry/BVH.h"
 #include "Geometry/Primitive.h"
 #include "Materials/Material.h"
 #include <vector>
@@ -19,10 +20,21 @@ namespace Geometry {
         inline void SetUVs(const std::vector<glm::vec2> &uvs) { m_texture_coords = uvs; }
         inline void SetIndices(const std::vector<uint32_t> &indices) { m_indices = indices; }
 
+        /** @brief Node format of the BVH made by the next `Build`. Quantized nodes are half the size but slower to traverse, see `QuantizedBVH4Node`. */
+        inline void SetBVHFormat(BVHFormat format) { m_bvh_format = format; }
+
         virtual std::optional<Intersection> Intersect(
             const Ray &ray,
             float tmin = 0,
             float tmax = std::numeric_limits<float>::infinity()) const override;
+        virtual bool Occluded(const Ray &ray, float tmin, float tmax) const override;
+        virtual AABB Bounds() const override;
+
+        /** @brief Builds the per-mesh triangle BVH. Call after the vertices and indices are final. */
+        virtual void Build(Platform::TaskScheduler *scheduler = nullptr) override;
+        virtual size_t AccelerationStructureBytes() const override { return m_bvh.MemoryUsage(); }
+
+        inline uint32_t TriangleCount() const { return static_cast<uint32_t>(m_indices.size() / 3); }
 
         template <VectorLike T>
         T Interpolate(float u, float v, T attribute0, T attribute1, T attribute2) const {
@@ -32,6 +44,11 @@ namespace Geometry {
         std::vector<glm::vec3> m_positions;
         std::vector<glm::vec2> m_texture_coords;
         std::vector<uint32_t> m_indices;
+
+        BVHFormat m_bvh_format = BVHFormat::Float;
+        BVH m_bvh;
+    private:
+        bool IntersectTriangle(const Ray &ray, uint32_t triangle, float tmin, float tmax, float &time, float &u, float &v) const;
     };
 
 }
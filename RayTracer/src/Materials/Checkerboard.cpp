@@ -11,12 +11,12 @@ namespace Materials {
         , m_scale(scale)
     {}
 
-    Color Checkerboard::Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int) const {
+    void Checkerboard::Scatter(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, int, ScatterResult &result) const {
         glm::vec2 uv = intersection.UV() * m_scale;
         int u = static_cast<int>(std::floor(uv.x));
         int v = static_cast<int>(std::floor(uv.y));
         Color base = (((u + v) & 1) == 0) ? m_color1 : m_color2;
-        return base * (scene.GetAmbientColor() + scene.DirectIllumination(intersection.Point(), intersection.Normal()));
+        result.local = base * (scene.GetAmbientColor() + scene.DirectIllumination(intersection.Point(), intersection.Normal()));
     }
 
 }
@@ -14,8 +14,22 @@ namespace Materials {
         , m_albedo(albedo)
     {}
 
-    Color Dielectric::Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int depth) const {
-        if (depth == 0) return Color(0.0f, 0.0f, 0.0f, 1.0f);
+    float Dielectric::ShadowTransmittance(const Geometry::Intersection &intersection, const Geometry::Ray &shadow_ray) const {
+        // Shadow rays are not bent, so the exit is taken along the same straight line as the entry
+        float eta = intersection.IsFrontFace() ? 1.0f / m_index_of_refraction : m_index_of_refraction;
+        float reflectance = ComputeReflectance(glm::normalize(shadow_ray.Direction()), intersection.Normal(), eta);
+        return m_diffuse_ratio + (1.0f - m_diffuse_ratio) * (1.0f - reflectance);
+    }
+
+    float Dielectric::MediumTransmittance(float distance) const {
+        return std::exp(-m_absorption * distance);
+    }
+
+    void Dielectric::Scatter(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, int depth, ScatterResult &result) const {
+        if (depth == 0) {
+            result.local = Color(0.0f, 0.0f, 0.0f, 1.0f);
+            return;
+        }
         
         bool entering = intersection.IsFrontFace();
         float eta = entering ? 1.0f / m_index_of_refraction : m_index_of_refraction;
@@ -23,43 +37,36 @@ namespace Materials {
 
         float reflectance = ComputeReflectance(direction, intersection.Normal(), eta);
     
-        Color result = 0.1f * m_albedo * scene.GetAmbientColor();
-        result.a = 1.0f;
+        result.local = 0.1f * m_albedo * scene.GetAmbientColor();
+        result.local.a = 1.0f;
 
         if (m_diffuse_ratio > 0.0f) {
             Color diffuse_part = scene.DirectIllumination(intersection.Point(), intersection.Normal());
-            result += m_diffuse_ratio * m_albedo * diffuse_part;
+            result.local += m_diffuse_ratio * m_albedo * diffuse_part;
         }
 
         if (m_diffuse_ratio < 1.0f) {
             float specular_scale = 1.0f - m_diffuse_ratio;
-            
-            Color reflected_component;
-            if (entering) {
-                glm::vec3 reflected_dir = glm::reflect(direction, intersection.Normal());
-                Geometry::Ray reflected_ray { intersection.Point() + 1e-4f * intersection.Normal(), reflected_dir };
-                reflected_component = tracer.Trace(scene, reflected_ray, depth - 1);
-            }
 
             glm::vec3 refracted_dir = glm::refract(direction, intersection.Normal(), eta);
-            Color transmitted_component { 0.0f };
             if (glm::length2(refracted_dir) > 0.0f) {
                 float optical_length = intersection.Time();
                 float beers_falloff = glm::exp(-m_absorption * optical_length);
 
                 Geometry::Ray refracted_ray { intersection.Point() - 1e-4f * intersection.Normal(), refracted_dir };
-                transmitted_component = tracer.Trace(scene, refracted_ray, depth - 1);
-                transmitted_component *= beers_falloff;
+                result.AddSecondary(refracted_ray, Color(specular_scale * (1.0f - reflectance) * beers_falloff));
             } else {
                 // if refraction is impossible, then we reflect entirely
                 reflectance = 1.0f;
             }
 
-            result += specular_scale * glm::mix(transmitted_component, reflected_component, reflectance);
+            // Inside the medium the reflected ray is not followed and contributes nothing
+            if (entering) {
+                glm::vec3 reflected_dir = glm::reflect(direction, intersection.Normal());
+                Geometry::Ray reflected_ray { intersection.Point() + 1e-4f * intersection.Normal(), reflected_dir };
+                result.AddSecondary(reflected_ray, Color(specular_scale * reflectance));
+            }
         }
-
-        return result;
-        
     }
 
     float Dielectric::ComputeReflectance(const glm::vec3 &direction, const glm::vec3 &normal, float eta) const {
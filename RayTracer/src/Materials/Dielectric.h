@@ -9,7 +9,10 @@ namespace Materials {
     class Dielectric : public Material {
     public:
         Dielectric(float index_of_refraction = 1.0f, float absorption = 0.0f, float diffuse_ratio = 0.0f, const Color &albedo = glm::vec4(1.0f));
-        virtual Color Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int depth) const override;
+        virtual void Scatter(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, int depth, ScatterResult &result) const override;
+        virtual bool IsOpaque() const override { return false; }
+        virtual float ShadowTransmittance(const Geometry::Intersection &intersection, const Geometry::Ray &shadow_ray) const override;
+        virtual float MediumTransmittance(float distance) const override;
         inline void SetAbsorption(float absorption) { m_absorption = absorption; }
 
         float ComputeReflectance(const glm::vec3 &direction, const glm::vec3 &normal, float eta) const;
@@ -9,8 +9,8 @@ namespace Materials {
         : m_albedo(albedo)
     {}
 
-    Color Diffuse::Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int) const {
-        return m_albedo * (scene.GetAmbientColor() + scene.DirectIllumination(intersection.Point(), intersection.Normal()));
+    void Diffuse::Scatter(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, int, ScatterResult &result) const {
+        result.local = m_albedo * (scene.GetAmbientColor() + scene.DirectIllumination(intersection.Point(), intersection.Normal()));
     }
 
 }
@@ -9,18 +9,20 @@ namespace Materials {
         , m_tint(tint)
     {}
 
-    Color Glossy::Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int depth) const {
+    void Glossy::Scatter(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, int depth, ScatterResult &result) const {
         Color diffuse_component = m_albedo * (scene.GetAmbientColor() + scene.DirectIllumination(intersection.Point(), intersection.Normal()));
         
-        if (depth == 0 || m_specularity == 0.0f) return diffuse_component;
-                
-        constexpr float epsilon = 1e-4f;
+        if (depth == 0 || m_specularity == 0.0f) {
+            result.local = diffuse_component;
+            return;
+        }
 
         glm::vec3 reflected_dir = glm::normalize(glm::reflect(in_ray.Direction(), intersection.Normal()));
         Geometry::Ray reflected_ray { intersection.Point() + 1e-4f * intersection.Normal(), reflected_dir };
-        Color specular_component = m_tint * tracer.Trace(scene, reflected_ray, depth - 1);
 
-        return glm::mix(diffuse_component, specular_component, m_specularity);
+        // mix(diffuse, tint * traced, specularity)
+        result.local = (1.0f - m_specularity) * diffuse_component;
+        result.AddSecondary(reflected_ray, m_specularity * m_tint);
     }
 
 }
@@ -9,7 +9,7 @@ namespace Materials {
     class Glossy : public Material {
     public:
         Glossy(const Color &albedo, float specularity = 1.0f, const Color &tint = Color(1.0f));
-        virtual Color Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int depth) const;
+        virtual void Scatter(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, int depth, ScatterResult &result) const override;
     private:
         Color m_albedo;
         float m_specularity;
@@ -0,0 +1,18 @@
+#include "Materials/Material.h"
+#include "Renderer/Tracer.h"
+#include "Utils/RayStats.h"
+
+namespace Materials {
+
+    Color Material::Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int depth) const {
+        ScatterResult result;
+        Scatter(intersection, scene, in_ray, depth, result);
+
+        Color color = result.local;
+        RAY_STATS_ADD(secondary_rays, result.secondary_count);
+        for (uint32_t i = 0; i < result.secondary_count; ++i)
+            color += result.secondary[i].weight * tracer.Trace(scene, result.secondary[i].ray, depth - 1);
+        return color;
+    }
+
+}
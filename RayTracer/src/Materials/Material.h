@@ -2,6 +2,7 @@
 
 #include "Common/Color.h"
 #include "Geometry/Ray.h"
+#include <cstdint>
 
 namespace Geometry { struct Intersection; }
 namespace Renderer { class Tracer; }
@@ -9,11 +10,52 @@ namespace Scene { class Scene; }
 
 namespace Materials {
 
+    /**
+     * @brief Outcome of a surface interaction: radiance produced at the hit itself plus the
+     * weighted secondary rays whose radiance still has to be added.
+     */
+    struct ScatterResult {
+        static constexpr uint32_t MAX_SECONDARY_RAYS = 2;
+
+        struct Secondary {
+            Geometry::Ray ray;
+            Color weight;
+        };
+
+        Color local { 0.0f };
+        Secondary secondary[MAX_SECONDARY_RAYS];
+        uint32_t secondary_count = 0;
+
+        inline void AddSecondary(const Geometry::Ray &ray, const Color &weight) {
+            secondary[secondary_count++] = { ray, weight };
+        }
+    };
+
     class Material {
     public:
         virtual ~Material() = default;
 
-        virtual Color Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int depth = 0) const = 0;
+        /**
+         * @brief Evaluates the interaction at `intersection` without tracing anything. Secondary
+         * rays are only emitted while `depth` is greater than zero and are to be traced at `depth - 1`.
+         */
+        virtual void Scatter(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, int depth, ScatterResult &result) const = 0;
+
+        /** @brief Recursively shades the interaction by tracing each secondary ray through `tracer`. */
+        virtual Color Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int depth = 0) const;
+
+        /** @brief Whether the surface blocks all light, which lets shadow rays stop at the first such hit. */
+        virtual bool IsOpaque() const { return true; }
+
+        /**
+         * @brief Fraction of a light's contribution that passes the surface at `intersection` of
+         * `shadow_ray`. Asked once per interface the shadow ray crosses, so a closed surface is asked
+         * on entry and on exit. Only asked of materials that are not opaque.
+         */
+        virtual float ShadowTransmittance(const Geometry::Intersection &intersection, const Geometry::Ray &shadow_ray) const { return 0.0f; }
+
+        /** @brief Fraction of a light's contribution that survives `distance` travelled inside the medium. */
+        virtual float MediumTransmittance(float distance) const { return 1.0f; }
     };
 
 }
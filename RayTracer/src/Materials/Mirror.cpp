@@ -7,12 +7,15 @@ namespace Materials {
         : m_tint(tint)
     {}
 
-    Color Mirror::Shade(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, const Renderer::Tracer &tracer, int depth) const {
-        if (depth == 0) return m_tint;
+    void Mirror::Scatter(const Geometry::Intersection &intersection, const Scene::Scene &scene, const Geometry::Ray &in_ray, int depth, ScatterResult &result) const {
+        if (depth == 0) {
+            result.local = m_tint;
+            return;
+        }
 
         glm::vec3 reflected_dir = glm::normalize(glm::reflect(in_ray.Direction(), intersection.Normal()));
         Geometry::Ray reflected_ray { intersection.Point() + 1e-4f * intersection.Normal(), reflected_dir };
-        return m_tint * tracer.Trace(scene, reflected_ray, depth - 1);
+        result.AddSecondary(reflected_ray, m_tint);
     }
 
 }
\ No newline at end of file
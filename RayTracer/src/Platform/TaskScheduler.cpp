@@ -0,0 +1,251 @@
+#include "Platform/TaskScheduler.h"
+#include "Utils/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace Platform {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        // Scheduler and worker index of the current thread, set for the scheduler's own threads
+        thread_local const TaskScheduler *t_scheduler = nullptr;
+        thread_local uint32_t t_worker = 0;
+
+        // Tasks may wait on nested groups, only the outermost task on a thread counts as busy time
+        thread_local uint32_t t_task_depth = 0;
+
+        // Victim selection state. Threads outside the scheduler all act as worker 0, so the seed is
+        // per thread rather than per worker; the scheduler's own threads reseed it from their index.
+        thread_local uint32_t t_steal_seed = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u;
+
+        // Idle rounds `Wait` spins through before it sleeps until a task is queued or the group finishes
+        constexpr uint32_t WAIT_SPIN_ROUNDS = 64;
+
+        inline uint64_t ElapsedNs(Clock::time_point start) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        }
+    }
+
+    TaskScheduler::TaskScheduler(uint32_t worker_count) {
+        worker_count = std::max(worker_count, 1u);
+
+        m_workers.reserve(worker_count);
+        for (uint32_t worker = 0; worker < worker_count; ++worker)
+            m_workers.push_back(std::make_unique<Worker>());
+
+        m_threads.reserve(worker_count - 1);
+        for (uint32_t worker = 1; worker < worker_count; ++worker)
+            m_threads.emplace_back(&TaskScheduler::WorkerLoop, this, worker);
+    }
+
+    TaskScheduler::~TaskScheduler() {
+        {
+            std::lock_guard lock(m_sleep_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+
+        for (auto &thread : m_threads)
+            thread.join();
+    }
+
+    uint32_t TaskScheduler::CurrentWorker() const {
+        return t_scheduler == this ? t_worker : 0;
+    }
+
+    void TaskScheduler::Spawn(TaskGroup &group, Task task) {
+        group.m_pending.fetch_add(1, std::memory_order_relaxed);
+
+        // Counted before the task is published, so that a thief popping it right away cannot take
+        // the count below zero
+        m_queued.fetch_add(1, std::memory_order_release);
+
+        Worker &worker = *m_workers[CurrentWorker()];
+        {
+            std::lock_guard lock(worker.mutex);
+            worker.tasks.push_back({ std::move(task), &group });
+        }
+
+        std::lock_guard lock(m_sleep_mutex);
+        m_wake.notify_one();
+    }
+
+    void TaskScheduler::Wait(TaskGroup &group) {
+        const uint32_t worker = CurrentWorker();
+        uint32_t idle_rounds = 0;
+        while (group.m_pending.load(std::memory_order_acquire) > 0) {
+            if (RunOne(worker)) {
+                idle_rounds = 0;
+                continue;
+            }
+
+            // The group's last tasks run elsewhere: spin for a moment, then sleep until there is
+            // something to run or the group is done
+            if (++idle_rounds < WAIT_SPIN_ROUNDS) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock lock(m_sleep_mutex);
+            m_wake.wait(lock, [this, &group] {
+                return group.m_pending.load(std::memory_order_acquire) == 0 || m_queued.load(std::memory_order_acquire) > 0;
+            });
+            idle_rounds = 0;
+        }
+    }
+
+    void TaskScheduler::ParallelFor(uint32_t count, const RangeTask &task, uint32_t grain) {
+        if (count == 0) return;
+
+        // A ParallelFor issued from inside a task runs within an outer one, whose time already counts
+        const bool outermost = t_task_depth == 0;
+        const auto start = Clock::now();
+        TaskGroup group;
+        grain = std::max(grain, 1u);
+        Spawn(group, [this, &group, count, grain, &task](uint32_t worker) {
+            SplitRange(group, 0, count, grain, task, worker);
+        });
+        Wait(group);
+        if (outermost)
+            m_parallel_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+    }
+
+    void TaskScheduler::SplitRange(TaskGroup &group, uint32_t begin, uint32_t end, uint32_t grain, const RangeTask &task, uint32_t worker) {
+        // Hand the upper halves to the deque, where they can be stolen, and keep splitting the lower half
+        while (end - begin > grain) {
+            uint32_t mid = begin + (end - begin) / 2;
+            Spawn(group, [this, &group, mid, end, grain, &task](uint32_t worker) {
+                SplitRange(group, mid, end, grain, task, worker);
+            });
+            end = mid;
+        }
+
+        for (uint32_t index = begin; index < end; ++index)
+            task(index, worker);
+    }
+
+    bool TaskScheduler::TryPop(uint32_t worker, QueuedTask &out) {
+        Worker &self = *m_workers[worker];
+        std::lock_guard lock(self.mutex);
+        if (self.tasks.empty()) return false;
+
+        out = std::move(self.tasks.back());
+        self.tasks.pop_back();
+        return true;
+    }
+
+    bool TaskScheduler::TrySteal(uint32_t worker, QueuedTask &out) {
+        const uint32_t worker_count = WorkerCount();
+        if (worker_count == 1) return false;
+
+        // Start at a pseudo-random victim so that thieves do not all hammer the same deque
+        Worker &self = *m_workers[worker];
+        t_steal_seed ^= t_steal_seed << 13;
+        t_steal_seed ^= t_steal_seed >> 17;
+        t_steal_seed ^= t_steal_seed << 5;
+        const uint32_t start = t_steal_seed % worker_count;
+
+        for (uint32_t i = 0; i < worker_count; ++i) {
+            uint32_t victim = (start + i) % worker_count;
+            if (victim == worker) continue;
+
+            Worker &other = *m_workers[victim];
+            std::lock_guard lock(other.mutex);
+            if (other.tasks.empty()) continue;
+
+            out = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            self.steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    bool TaskScheduler::RunOne(uint32_t worker) {
+        QueuedTask task;
+        if (!TryPop(worker, task) && !TrySteal(worker, task))
+            return false;
+
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        Execute(worker, task);
+        return true;
+    }
+
+    void TaskScheduler::Execute(uint32_t worker, QueuedTask &task) {
+        Worker &self = *m_workers[worker];
+        const bool outermost = t_task_depth++ == 0;
+        const auto start = Clock::now();
+
+        task.task(worker);
+
+        --t_task_depth;
+        if (outermost)
+            self.busy_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+        self.executed.fetch_add(1, std::memory_order_relaxed);
+
+        // Wake threads sleeping in `Wait` once the group's last task is done
+        if (task.group->m_pending.fetch_sub(1, std::memory_order_release) == 1) {
+            std::lock_guard lock(m_sleep_mutex);
+            m_wake.notify_all();
+        }
+    }
+
+    void TaskScheduler::WorkerLoop(uint32_t worker) {
+        t_scheduler = this;
+        t_worker = worker;
+        t_steal_seed = 0x9e3779b9u * (worker + 1);
+        Utils::Profiler::SetThreadName("Worker " + std::to_string(worker));
+
+        while (true) {
+            if (RunOne(worker)) continue;
+
+            std::unique_lock lock(m_sleep_mutex);
+            m_wake.wait(lock, [this] { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+            if (m_stop) return;
+        }
+    }
+
+    std::vector<TaskScheduler::WorkerStats> TaskScheduler::GetWorkerStats() const {
+        std::vector<WorkerStats> stats;
+        stats.reserve(m_workers.size());
+        for (const auto &worker : m_workers) {
+            stats.push_back({
+                worker->busy_ns.load(std::memory_order_relaxed),
+                worker->executed.load(std::memory_order_relaxed),
+                worker->steals.load(std::memory_order_relaxed)
+            });
+        }
+        return stats;
+    }
+
+    void TaskScheduler::ResetStats() {
+        for (auto &worker : m_workers) {
+            worker->busy_ns.store(0, std::memory_order_relaxed);
+            worker->executed.store(0, std::memory_order_relaxed);
+            worker->steals.store(0, std::memory_order_relaxed);
+        }
+        m_parallel_ns.store(0, std::memory_order_relaxed);
+    }
+
+    void TaskScheduler::LogUtilization() const {
+        const double parallel_ns = static_cast<double>(m_parallel_ns.load(std::memory_order_relaxed));
+        std::ostringstream out;
+
+        out << "\n----- Worker Utilization -----\n";
+        const auto stats = GetWorkerStats();
+        for (uint32_t worker = 0; worker < stats.size(); ++worker) {
+            double utilization = parallel_ns > 0.0 ? 100.0 * stats[worker].busy_ns / parallel_ns : 0.0;
+            out << "worker " << std::setw(3) << std::left << worker
+                << "  busy: " << std::right << std::setw(5) << std::fixed << std::setprecision(1) << utilization << "%" << std::left
+                << "  tasks: " << std::setw(8) << stats[worker].tasks
+                << "  steals: " << stats[worker].steals
+                << '\n';
+        }
+        std::cout << out.str();
+    }
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Common/NonCopyable.h"
+#include "Common/NonMovable.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Platform {
+
+    /**
+     * @brief Work-stealing task scheduler. Every worker owns a deque: it pushes and pops its
+     * own tasks at the back and idle workers steal the oldest (largest) tasks from the front
+     * of someone else's deque.
+     *
+     * The thread that drives the scheduler (the one calling `ParallelFor` or `Wait`) acts as
+     * worker 0, so a scheduler with N workers owns N - 1 threads.
+     */
+    class TaskScheduler : private NonCopyable, private NonMovable {
+    public:
+        using Task = std::function<void(uint32_t worker)>;
+        using RangeTask = std::function<void(uint32_t index, uint32_t worker)>;
+
+        /** @brief Counts outstanding tasks so that a caller can wait for the ones it spawned. */
+        class TaskGroup {
+        private:
+            friend class TaskScheduler;
+            std::atomic<uint32_t> m_pending = 0;
+        };
+
+        struct WorkerStats {
+            uint64_t busy_ns = 0;
+            uint64_t tasks = 0;
+            uint64_t steals = 0;
+        };
+
+        explicit TaskScheduler(uint32_t worker_count = std::thread::hardware_concurrency());
+        ~TaskScheduler();
+
+        inline uint32_t WorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+        /** @brief Queues `task` on the calling worker's deque as part of `group`. */
+        void Spawn(TaskGroup &group, Task task);
+
+        /**
+         * @brief Executes and steals tasks until every task of `group` has finished. When there is
+         * nothing to run it spins briefly and then sleeps until a task is queued or the group is done.
+         */
+        void Wait(TaskGroup &group);
+
+        /**
+         * @brief Runs `task(index, worker)` for every index in [0, count) and blocks until done.
+         * The range is split recursively so that thieves take large halves first; ranges no
+         * larger than `grain` run on a single worker.
+         */
+        void ParallelFor(uint32_t count, const RangeTask &task, uint32_t grain = 1);
+
+        std::vector<WorkerStats> GetWorkerStats() const;
+        void ResetStats();
+
+        /** @brief Prints the share of time each worker spent executing tasks inside `ParallelFor`. */
+        void LogUtilization() const;
+    private:
+        struct QueuedTask {
+            Task task;
+            TaskGroup *group;
+        };
+
+        struct alignas(64) Worker {
+            std::mutex mutex;
+            std::deque<QueuedTask> tasks;
+
+            std::atomic<uint64_t> busy_ns = 0;
+            std::atomic<uint64_t> executed = 0;
+            std::atomic<uint64_t> steals = 0;
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread> m_threads;
+
+        std::atomic<uint32_t> m_queued = 0;
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_wake;
+        bool m_stop = false;
+
+        std::atomic<uint64_t> m_parallel_ns = 0;
+    private:
+        void WorkerLoop(uint32_t worker);
+        uint32_t CurrentWorker() const;
+
+        bool TryPop(uint32_t worker, QueuedTask &out);
+        bool TrySteal(uint32_t worker, QueuedTask &out);
+        bool RunOne(uint32_t worker);
+        void Execute(uint32_t worker, QueuedTask &task);
+
+        void SplitRange(TaskGroup &group, uint32_t begin, uint32_t end, uint32_t grain, const RangeTask &task, uint32_t worker);
+    };
+
+}
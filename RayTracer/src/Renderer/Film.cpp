@@ -1,14 +1,21 @@
 #include "Film.h"
 #include "Common/Color.h"
+#include "Utils/Profiler.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace Renderer {
 
     Film::Film(uint32_t width, uint32_t height, VkFormat format, const Color &initial_color)
@@ -16,7 +23,15 @@ namespace Renderer {
         , m_height{height}
         , m_format(format)
         , m_data(width * height * CHANNEL_COUNT)
+        , m_accum(width * height, Color(0.0f))
+        , m_luminance_mean(width * height, 0.0f)
+        , m_luminance_m2(width * height, 0.0f)
+        , m_sample_count(width * height, 0u)
+        , m_tiles_x((width + TILE_SIZE - 1) / TILE_SIZE)
+        , m_tiles_y((height + TILE_SIZE - 1) / TILE_SIZE)
     {
+        m_dirty_tiles.assign(m_tiles_x * m_tiles_y, 0);
+
         switch (format) {
             case VK_FORMAT_R8G8B8A8_UNORM: {
                 m_layout = Layout::RGBA;
@@ -43,20 +58,6 @@ namespace Renderer {
         }
     }
 
-    void Film::PutColor(uint32_t i, uint32_t j, const Color &color) {
-        if (m_layout == Layout::RGBA) {
-            m_data[Index(i, j, 0)] = Pack(color.r);
-            m_data[Index(i, j, 1)] = Pack(color.g);
-            m_data[Index(i, j, 2)] = Pack(color.b);
-            m_data[Index(i, j, 3)] = Pack(color.a);
-        } else if (m_layout == Layout::BGRA) {
-            m_data[Index(i, j, 0)] = Pack(color.b);
-            m_data[Index(i, j, 1)] = Pack(color.g);
-            m_data[Index(i, j, 2)] = Pack(color.r);
-            m_data[Index(i, j, 3)] = Pack(color.a);
-        }
-    }
-
     void Film::Fill(const Color &color) {
         std::array<uint8_t, 4> packed;
         if (m_layout == Layout::RGBA) {
@@ -78,7 +79,90 @@ namespace Renderer {
         std::fill_n(dest, word_count, pixel);
     }
 
+    float Film::RelativeError(uint32_t i, uint32_t j) const {
+        // Keeps near-black pixels, whose relative error is unstable, from never converging
+        constexpr float DARK_LUMINANCE = 1e-2f;
+
+        const uint32_t pixel = j * m_width + i;
+        const uint32_t count = m_sample_count[pixel];
+        if (count < 2) return std::numeric_limits<float>::infinity();
+
+        const float n = static_cast<float>(count);
+        const float mean = m_luminance_mean[pixel];
+        const float variance = m_luminance_m2[pixel] / (n - 1.0f);
+        return std::sqrt(variance / n) / (std::abs(mean) + DARK_LUMINANCE);
+    }
+
+    void Film::Resolve() {
+        PROFILE_SCOPE(Film, "Film Resolve");
+
+        for (uint32_t tile_y = 0; tile_y < m_tiles_y; ++tile_y) {
+            for (uint32_t tile_x = 0; tile_x < m_tiles_x; ++tile_x) {
+                uint8_t &dirty = m_dirty_tiles[tile_y * m_tiles_x + tile_x];
+                if (!dirty) continue;
+
+                ResolveTile(tile_x, tile_y);
+                dirty = 0;
+            }
+        }
+    }
+
+    void Film::ResolveTile(uint32_t tile_x, uint32_t tile_y) {
+        const uint32_t x_begin = tile_x * TILE_SIZE;
+        const uint32_t y_begin = tile_y * TILE_SIZE;
+        const uint32_t x_end = std::min(x_begin + TILE_SIZE, m_width);
+        const uint32_t y_end = std::min(y_begin + TILE_SIZE, m_height);
+
+        const auto &srgb_table = Common::SRGBLookupTable();
+        const bool swap_red_blue = m_layout == Layout::BGRA;
+
+        for (uint32_t j = y_begin; j < y_end; ++j) {
+            for (uint32_t i = x_begin; i < x_end; ++i) {
+                const uint32_t pixel = j * m_width + i;
+                const uint32_t count = m_sample_count[pixel];
+                if (count == 0) continue;
+
+                uint8_t *out = &m_data[Index(i, j)];
+                const float inverse_count = 1.0f / static_cast<float>(count);
+
+#if defined(__SSE2__)
+                // Average, clamp and swizzle all four channels at once
+                __m128 value = _mm_mul_ps(_mm_loadu_ps(&m_accum[pixel].r), _mm_set1_ps(inverse_count));
+                value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                if (swap_red_blue)
+                    value = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 0, 1, 2));
+
+                if (m_is_linear_colorspace) {
+                    __m128i bytes = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+                    bytes = _mm_packs_epi32(bytes, bytes);
+                    bytes = _mm_packus_epi16(bytes, bytes);
+                    const uint32_t packed = static_cast<uint32_t>(_mm_cvtsi128_si32(bytes));
+                    std::memcpy(out, &packed, CHANNEL_COUNT);
+                } else {
+                    alignas(16) int32_t indices[CHANNEL_COUNT];
+                    _mm_store_si128(reinterpret_cast<__m128i *>(indices),
+                        _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(Common::SRGB_LUT_SIZE - 1)), _mm_set1_ps(0.5f))));
+                    for (uint32_t c = 0; c < CHANNEL_COUNT; ++c)
+                        out[c] = srgb_table[indices[c]];
+                }
+#else
+                Color value = glm::clamp(m_accum[pixel] * inverse_count, 0.0f, 1.0f);
+                if (swap_red_blue)
+                    value = Color(value.b, value.g, value.r, value.a);
+
+                for (uint32_t c = 0; c < CHANNEL_COUNT; ++c) {
+                    out[c] = m_is_linear_colorspace
+                        ? static_cast<uint8_t>(value[c] * 255.0f + 0.5f)
+                        : srgb_table[static_cast<uint32_t>(value[c] * (Common::SRGB_LUT_SIZE - 1) + 0.5f)];
+                }
+#endif
+            }
+        }
+    }
+
     void Film::WriteToImage(const std::string &output_path) {
+        Resolve();
+
         std::cout << "writing to image" << std::endl;
         std::cout << "Dimensions: " << m_width << " x " << m_height << std::endl;
 
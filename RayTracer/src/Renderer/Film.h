@@ -1,21 +1,59 @@
 #pragma once
 
+#include <string>
 #include <vector>
 #include <volk.h>
 #include "Common/Color.h"
 
 namespace Renderer {
 
+    /**
+     * @brief Accumulates radiance samples in floating point and resolves them into the 8-bit
+     * presentation format on demand. Only tiles that received samples since the last resolve
+     * are converted again.
+     */
     class Film {
     public:
+        /** @brief Side of the square tiles used for dirty tracking; renderers split work on the same grid. */
+        static constexpr uint32_t TILE_SIZE = 32;
+
         Film(uint32_t width, uint32_t height, VkFormat format, const Color &initial_color = glm::vec4{ 0.0f });
-        std::vector<uint8_t> &Data() { return m_data; }
+
+        /** @brief Resolved pixels in the film's format. Resolves any dirty tiles first. */
+        const std::vector<uint8_t> &Data() { Resolve(); return m_data; }
         uint32_t Width() const { return m_width; }
         uint32_t Height() const { return m_height; }
 
-        void PutColor(uint32_t i, uint32_t j, const Color &color);
+        /**
+         * @brief Adds one sample to pixel (i, j). Not synchronized: concurrent callers must write
+         * to different tiles.
+         */
+        inline void AddSample(uint32_t i, uint32_t j, const Color &color) {
+            const uint32_t pixel = j * m_width + i;
+            m_accum[pixel] += color;
+            m_sample_count[pixel] += 1;
+
+            // Welford's update: unlike a sum of squares it does not cancel once the mean dominates the spread
+            const float luminance = Common::Luminance(color);
+            const float delta = luminance - m_luminance_mean[pixel];
+            m_luminance_mean[pixel] += delta / static_cast<float>(m_sample_count[pixel]);
+            m_luminance_m2[pixel] += delta * (luminance - m_luminance_mean[pixel]);
+            m_dirty_tiles[(j / TILE_SIZE) * m_tiles_x + (i / TILE_SIZE)] = 1;
+        }
+
+        inline uint32_t SampleCount(uint32_t i, uint32_t j) const { return m_sample_count[j * m_width + i]; }
+
+        /**
+         * @brief Standard error of the mean luminance of pixel (i, j) relative to that mean, from
+         * the running moments of the samples. Infinite while the pixel has fewer than two samples.
+         */
+        float RelativeError(uint32_t i, uint32_t j) const;
+
         void Fill(const Color &color);
 
+        /** @brief Converts the accumulated average of every dirty tile to the output format. */
+        void Resolve();
+
         void WriteToImage(const std::string &output_path);
         
     private:
@@ -23,16 +61,23 @@ namespace Renderer {
         constexpr static uint32_t CHANNEL_COUNT = 4;
 
         std::vector<Color> m_accum;
+        std::vector<float> m_luminance_mean;    // running mean of the sample luminances
+        std::vector<float> m_luminance_m2;      // running sum of squared deviations from that mean
+        std::vector<uint32_t> m_sample_count;
+        std::vector<uint8_t> m_dirty_tiles;
         std::vector<uint8_t> m_data {};
         VkFormat m_format;
         uint32_t m_width {};
         uint32_t m_height {};
+        uint32_t m_tiles_x {};
+        uint32_t m_tiles_y {};
 
         Layout m_layout = Layout::RGBA;
         bool m_is_linear_colorspace = true;
     private:
         uint32_t Index(uint32_t i, uint32_t j, uint32_t c = 0) const;
         uint8_t Pack(float value);
+        void ResolveTile(uint32_t tile_x, uint32_t tile_y);
     };
 
 }
@@ -0,0 +1,93 @@
+#include "Renderer/HeatmapTracer.h"
+#include "Utils/RayStats.h"
+#include <array>
+#include <chrono>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+
+        // Per-sample cost in the units of `mode`, measured on the calling thread's counters
+        struct CostCounters {
+            uint64_t primitive_tests;
+            uint64_t box_tests;
+            uint64_t rays;
+        };
+
+        CostCounters ReadCounters() {
+            const auto &local = Utils::RayStats::Local();
+            constexpr auto relaxed = std::memory_order_relaxed;
+            return {
+                local.primitive_tests.load(relaxed) + local.triangle_tests.load(relaxed),
+                local.box_tests.load(relaxed),
+                local.secondary_rays.load(relaxed) + local.shadow_rays.load(relaxed)
+            };
+        }
+
+        float DefaultMaxValue(HeatmapMode mode) {
+            switch (mode) {
+                case HeatmapMode::PrimitiveTests: return 64.0f;
+                case HeatmapMode::BoxTests:       return 128.0f;
+                case HeatmapMode::Rays:           return 32.0f;
+                default:                          return 20000.0f;
+            }
+        }
+
+    }
+
+    HeatmapTracer::HeatmapTracer(std::unique_ptr<Tracer> inner, HeatmapMode mode, float max_value)
+        : m_inner(std::move(inner))
+        , m_mode(mode)
+    {
+    #ifndef UTILS_RayStats
+        if (mode != HeatmapMode::Time)
+            throw std::runtime_error("HeatmapTracer: counting modes require UTILS_RayStats");
+    #endif
+        SetMaxValue(max_value);
+    }
+
+    void HeatmapTracer::SetMaxValue(float max_value) {
+        m_max_value = max_value > 0.0f ? max_value : DefaultMaxValue(m_mode);
+    }
+
+    Color HeatmapTracer::Trace(const Scene::Scene &scene, const Geometry::Ray &ray, uint32_t depth) const {
+        float cost = 0.0f;
+
+        if (m_mode == HeatmapMode::Time) {
+            const auto start = std::chrono::steady_clock::now();
+            m_inner->Trace(scene, ray, depth);
+            cost = std::chrono::duration<float, std::nano>(std::chrono::steady_clock::now() - start).count();
+        } else {
+            const CostCounters before = ReadCounters();
+            m_inner->Trace(scene, ray, depth);
+            const CostCounters after = ReadCounters();
+
+            switch (m_mode) {
+                case HeatmapMode::PrimitiveTests: cost = float(after.primitive_tests - before.primitive_tests); break;
+                case HeatmapMode::BoxTests:       cost = float(after.box_tests - before.box_tests); break;
+                default:                          cost = float(after.rays - before.rays); break;
+            }
+        }
+
+        return Colormap(cost / m_max_value);
+    }
+
+    Color HeatmapTracer::Colormap(float t) {
+        static const std::array<glm::vec3, 5> ramp {
+            glm::vec3(0.0f, 0.0f, 0.5f),
+            glm::vec3(0.0f, 0.6f, 1.0f),
+            glm::vec3(0.1f, 0.9f, 0.2f),
+            glm::vec3(1.0f, 0.9f, 0.0f),
+            glm::vec3(1.0f, 0.1f, 0.0f)
+        };
+
+        if (t > 1.0f) return Color(1.0f);
+
+        const float x = glm::max(t, 0.0f) * float(ramp.size() - 1);
+        const uint32_t i = glm::min(uint32_t(x), uint32_t(ramp.size() - 2));
+        const glm::vec3 rgb = glm::mix(ramp[i], ramp[i + 1], x - float(i));
+        return Color(rgb, 1.0f);
+    }
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Geometry/Ray.h"
+#include "Renderer/Tracer.h"
+#include <memory>
+
+namespace Renderer {
+
+    enum class HeatmapMode {
+        PrimitiveTests,     // primitive and triangle intersection tests
+        BoxTests,           // acceleration structure nodes visited
+        Rays,               // secondary and shadow rays spawned by the sample
+        Time                // nanoseconds spent tracing the sample
+    };
+
+    /**
+     * @brief Debug tracer that colours every sample by what it cost the wrapped tracer instead of
+     * by its radiance. Costs are mapped from [0, max] onto a blue-green-yellow-red ramp, anything
+     * above max saturates to white.
+     *
+     * All modes but `Time` read the calling thread's ray statistics and require `UTILS_RayStats`.
+     */
+    class HeatmapTracer : public Tracer {
+    public:
+        HeatmapTracer(std::unique_ptr<Tracer> inner, HeatmapMode mode, float max_value = 0.0f);
+        virtual Color Trace(const Scene::Scene &scene, const Geometry::Ray &ray, uint32_t depth) const override;
+
+        /** @brief Cost that maps to the top of the ramp, 0 selects a default for the mode. */
+        void SetMaxValue(float max_value);
+
+        static Color Colormap(float t);
+    private:
+        std::unique_ptr<Tracer> m_inner;
+        HeatmapMode m_mode;
+        float m_max_value;
+    };
+
+}
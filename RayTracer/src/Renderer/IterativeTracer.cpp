@@ -0,0 +1,85 @@
+#include "Renderer/IterativeTracer.h"
+#include "Common/Hash.h"
+#include "Materials/Material.h"
+#include "Renderer/Renderer.h"
+#include "Utils/RayStats.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace Renderer {
+
+    static_assert(Renderer::MAX_RAY_DEPTH <= IterativeTracer::MAX_DEPTH, "the work stack is too small for the renderer's ray depth");
+
+    namespace {
+
+        struct PathVertex {
+            Geometry::Ray ray;
+            Color throughput;
+            uint32_t depth;
+        };
+
+        // Stateless uniform number in [0, 1) derived from the ray itself, so the tracer stays const
+        // and thread-safe without carrying a generator around
+        float RouletteSample(const Geometry::Ray &ray, uint32_t depth) {
+            uint32_t h = Common::Hash(depth);
+            for (int i = 0; i < 3; ++i) {
+                h = Common::HashCombine(h, std::bit_cast<uint32_t>(ray.Origin()[i]));
+                h = Common::HashCombine(h, std::bit_cast<uint32_t>(ray.Direction()[i]));
+            }
+            return float(h >> 8) * 0x1p-24f;
+        }
+
+    }
+
+    IterativeTracer::IterativeTracer(float throughput_cutoff, bool russian_roulette)
+        : m_throughput_cutoff(throughput_cutoff)
+        , m_russian_roulette(russian_roulette)
+    {}
+
+    Color IterativeTracer::Trace(const Scene::Scene &scene, const Geometry::Ray &ray, uint32_t depth) const {
+        assert(depth <= MAX_DEPTH && "IterativeTracer: depth exceeds the work stack bound");
+
+        PathVertex stack[MAX_STACK_SIZE];
+        uint32_t stack_size = 0;
+        stack[stack_size++] = { ray, Color(1.0f), depth };
+
+        Color radiance { 0.0f };
+        Materials::ScatterResult result;
+
+        while (stack_size > 0) {
+            const PathVertex vertex = stack[--stack_size];
+
+            const auto intersection = scene.IntersectNearest(vertex.ray);
+            if (!intersection.has_value()) {
+                radiance += vertex.throughput * scene.GetBackgroundColor();
+                continue;
+            }
+
+            result.secondary_count = 0;
+            intersection->Material()->Scatter(*intersection, scene, vertex.ray, static_cast<int>(vertex.depth), result);
+            radiance += vertex.throughput * result.local;
+
+            for (uint32_t i = 0; i < result.secondary_count; ++i) {
+                Color throughput = vertex.throughput * result.secondary[i].weight;
+                float magnitude = std::max({ throughput.r, throughput.g, throughput.b });
+                if (magnitude < m_throughput_cutoff)
+                    continue;
+
+                if (m_russian_roulette && magnitude < ROULETTE_THRESHOLD) {
+                    float survival = magnitude / ROULETTE_THRESHOLD;
+                    if (RouletteSample(result.secondary[i].ray, vertex.depth) >= survival)
+                        continue;
+                    throughput /= survival;
+                }
+
+                assert(stack_size < MAX_STACK_SIZE);
+                stack[stack_size++] = { result.secondary[i].ray, throughput, vertex.depth - 1 };
+                RAY_STATS_INC(secondary_rays);
+            }
+        }
+
+        return radiance;
+    }
+
+}
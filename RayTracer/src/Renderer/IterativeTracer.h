@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Geometry/Ray.h"
+#include "Materials/Material.h"
+#include "Renderer/Tracer.h"
+
+namespace Renderer {
+
+    /**
+     * @brief Whitted-style tracer that follows secondary rays with an explicit work stack instead
+     * of recursing through the materials.
+     *
+     * Each pending ray carries the throughput it contributes to the camera sample. Branches whose
+     * throughput drops below the cutoff are discarded, which keeps nested dielectrics from fanning
+     * out into 2^depth rays. With Russian roulette enabled, dim branches above the cutoff are
+     * terminated randomly and the survivors reweighted, so the estimate stays unbiased. The cutoff
+     * looks at the RGB channels only; alpha carries no energy.
+     */
+    class IterativeTracer : public Tracer {
+    public:
+        IterativeTracer(float throughput_cutoff = 1e-3f, bool russian_roulette = false);
+        virtual Color Trace(const Scene::Scene &scene, const Geometry::Ray &ray, uint32_t depth) const override;
+
+        inline void SetThroughputCutoff(float cutoff) { m_throughput_cutoff = cutoff; }
+        inline void SetRussianRoulette(bool enabled) { m_russian_roulette = enabled; }
+        /** @brief Deepest ray the work stack is sized for, `Trace` asserts `depth` stays within it. */
+        static constexpr uint32_t MAX_DEPTH = 32;
+    private:
+        // Every pop replaces one entry by at most MAX_SECONDARY_RAYS entries one level deeper and
+        // materials emit nothing at depth 0, so a depth-first walk from depth d holds at most
+        // (MAX_SECONDARY_RAYS - 1) * d + 1 entries
+        static constexpr uint32_t MAX_STACK_SIZE = (Materials::ScatterResult::MAX_SECONDARY_RAYS - 1) * MAX_DEPTH + 1;
+
+        // Branches dimmer than this take part in Russian roulette
+        static constexpr float ROULETTE_THRESHOLD = 0.1f;
+
+        float m_throughput_cutoff;
+        bool m_russian_roulette;
+    };
+
+}
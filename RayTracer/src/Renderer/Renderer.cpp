@@ -1,9 +1,13 @@
 #include "Renderer.h"
+#include "Common/Random.h"
 #include "Utils/Profiler.h"
 #include "glm/fwd.hpp"
+#include <chrono>
 #include <cstdlib>
+#include <iomanip>
 #include <iostream>
-#include <random>
+#include <limits>
+#include <sstream>
 
 namespace Renderer {
 
@@ -11,23 +15,30 @@ namespace Renderer {
         : m_film(width, height, format)
         , m_tracer(std::move(tracer))
         , m_samples_per_pixel(samples_per_pixel)
+        , m_schedule(width, height, samples_per_pixel, 0, TILE_SIZE)
     {
         m_film.Fill(Color(0.0f, 0.0f, 0.0f, 1.0f));
 
-        random_indices.resize(width * height * m_samples_per_pixel);
-        
-        for (uint32_t i = 0; i < width * height; ++i)
-            for (uint32_t s = 0; s < m_samples_per_pixel; ++s)
-                random_indices[i * m_samples_per_pixel + s] = i;
+        m_tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+        m_tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+        m_tile_offsets.resize(m_tiles_x * m_tiles_y + 1);
+    }
+
+    void Renderer::SetSeed(uint32_t seed) {
+        m_seed = seed;
+        m_schedule.SetSeed(seed);
+    }
 
-        m_accum.assign(width * height, Color(0.0f));
-        m_sample_count.assign(width * height, 0u);
+    void Renderer::SetAdaptiveSampling(float threshold, uint32_t min_samples) {
+        m_error_threshold = threshold;
+        m_min_samples = std::max(min_samples, 2u);
 
-        static std::mt19937 rng { std::random_device{}() };
-        std::shuffle(random_indices.begin(), random_indices.end(), rng);
+        // Schedule the extra passes that noisy pixels may need; the budget cuts the render short of them
+        const uint64_t scheduled = threshold > 0.0f ? uint64_t(m_samples_per_pixel) * ADAPTIVE_SAMPLE_SCALE : m_samples_per_pixel;
+        m_schedule.SetSamplesPerPixel(static_cast<uint32_t>(std::min<uint64_t>(scheduled, std::numeric_limits<uint32_t>::max())));
     }
 
-    void _DrawProgressBar(uint32_t progress, uint32_t total) {
+    void _DrawProgressBar(uint64_t progress, uint64_t total, double mrays_per_second) {
         float pct = float(progress) / float(total);
         const int barWidth = 50;
         int pos = int(pct * barWidth);
@@ -40,6 +51,11 @@ namespace Renderer {
         }
         std::cout << "] " << int(pct * 100.0f) << "%  ("
                 << progress << "/" << total << ")";
+    #ifdef UTILS_RayStats
+        std::ostringstream rate;
+        rate << std::fixed << std::setprecision(2) << mrays_per_second;
+        std::cout << "  " << rate.str() << " Mrays/s   ";
+    #endif
 
         std::cout.flush();
     }
@@ -47,42 +63,131 @@ namespace Renderer {
     std::pair<Film &, bool> Renderer::RenderToFilm(Scene::Scene &scene) {
         PROFILE_FUNCTION_AUTO();
         
-        const uint32_t total_pixel = static_cast<uint32_t>(random_indices.size());
-
-        const uint32_t total_rays = static_cast<uint32_t>(random_indices.size());
-        if (m_current_offset >= total_rays) {
+        const uint64_t total_rays = m_schedule.TotalSamples();
+        if (m_current_offset >= total_rays || m_budget_spent) {
             return { m_film, true };
         }
 
-        const uint32_t remaining = total_rays - m_current_offset;
-        const uint32_t samples_this_frame = std::min(SAMPLES_PER_FRAME, remaining);
+        const auto frame_start = std::chrono::steady_clock::now();
+        if (m_current_offset == 0) {
+            m_start_counts = m_frame_counts = Utils::RayStats::Snapshot();
+            m_render_seconds = 0.0;
+            m_scheduler.ResetStats();   // drops work done before the render, e.g. the scene build
+            m_skipped_samples = 0;
+        }
 
-        for (size_t k = 0; k < samples_this_frame; ++k) {
-            uint32_t index = random_indices[m_current_offset + k];
-            uint32_t x = index % m_film.Width();
-            uint32_t y = index / m_film.Width();
-            uint32_t px = y * m_film.Width() + x;
+        // With adaptive sampling frames end at pass boundaries, where the budget is checked
+        uint64_t remaining = total_rays - m_current_offset;
+        if (m_error_threshold > 0.0f) {
+            const uint64_t pass_size = m_schedule.PassSize();
+            remaining = std::min(remaining, pass_size - m_current_offset % pass_size);
+        }
+        const uint32_t samples_this_frame = static_cast<uint32_t>(std::min<uint64_t>(FrameSampleCount(), remaining));
+
+        // Counting sort of this frame's samples by tile
+        const uint32_t tile_count = m_tiles_x * m_tiles_y;
+        m_frame_samples.resize(samples_this_frame);
+        std::fill(m_tile_offsets.begin(), m_tile_offsets.end(), 0u);
+        for (uint32_t k = 0; k < samples_this_frame; ++k) {
+            const uint64_t sample = m_current_offset + k;
+            m_frame_samples[k] = { m_schedule.PixelAt(sample), m_schedule.SampleIndexAt(sample) };
+            m_tile_offsets[TileOf(m_frame_samples[k].pixel) + 1]++;
+        }
+        for (uint32_t tile = 0; tile < tile_count; ++tile)
+            m_tile_offsets[tile + 1] += m_tile_offsets[tile];
+
+        m_tile_samples.resize(samples_this_frame);
+        std::vector<uint32_t> cursor(m_tile_offsets.begin(), m_tile_offsets.end() - 1);
+        for (const FrameSample &sample : m_frame_samples)
+            m_tile_samples[cursor[TileOf(sample.pixel)]++] = sample;
+
+        // Tile costs vary wildly (sky vs. deep glass), idle workers steal tiles from busy ones
+        m_scheduler.ParallelFor(tile_count, [&](uint32_t tile, uint32_t) {
+            RenderTile(scene, tile);
+        });
+        m_current_offset += samples_this_frame;
+        if (m_error_threshold > 0.0f && m_current_offset % m_schedule.PassSize() == 0)
+            m_budget_spent = TracedSamples() >= SampleBudget();
+        const bool complete = m_current_offset >= total_rays || m_budget_spent;
 
-            static thread_local std::mt19937 gen{ std::random_device{}() };
-            static thread_local std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-            float ux = float(x) + dist(gen);
-            float uy = float(y) + dist(gen);
-            Geometry::Ray ray = scene.GetCamera().GenerateRay(ux, uy);
-            Color result_color = m_tracer->Trace(scene, ray, MAX_RAY_DEPTH);
-            // m_film.PutColor(x, y, result_color / float(m_samples_per_pixel));
+        const double frame_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_start).count();
+        m_render_seconds += frame_seconds;
 
-            m_accum[px] += result_color;
-            m_sample_count[px] += 1;
+        // Exponential moving average, so one slow frame (a page fault, a busy desktop) does not halve the next
+        const double seconds_per_sample = frame_seconds / double(samples_this_frame);
+        if (m_seconds_per_sample == 0.0) m_seconds_per_sample = seconds_per_sample;
+        else m_seconds_per_sample += FRAME_COST_SMOOTHING * (seconds_per_sample - m_seconds_per_sample);
 
-            Color avg = m_accum[px] / float(m_sample_count[px]);
-            m_film.PutColor(x, y, avg);
-        }
-        m_current_offset += samples_this_frame;
+        const Utils::RayCounts counts = Utils::RayStats::Snapshot();
+        const double mrays_per_second = double((counts - m_frame_counts).Rays()) / frame_seconds * 1e-6;
+        m_frame_counts = counts;
 
         // --- draw progress bar ---
-        _DrawProgressBar(m_current_offset, total_rays);
+        if (m_verbose) {
+            if (m_error_threshold > 0.0f) _DrawProgressBar(std::min(TracedSamples(), SampleBudget()), SampleBudget(), mrays_per_second);
+            else _DrawProgressBar(m_current_offset, total_rays, mrays_per_second);
+        }
+
+        if (m_verbose && complete) {
+            m_scheduler.LogUtilization();
+        #ifdef UTILS_RayStats
+            Utils::RayStats::LogSummary(counts - m_start_counts, m_render_seconds);
+        #endif
+            if (m_error_threshold > 0.0f) {
+                std::cout << "adaptive sampling: traced " << TracedSamples() << " samples of a budget of " << SampleBudget()
+                          << ", skipped " << m_skipped_samples.load() << " on converged pixels\n";
+            }
+        }
 
         return { m_film, false };
     }
 
+    uint32_t Renderer::FrameSampleCount() const {
+        if (m_seconds_per_sample == 0.0)
+            return INITIAL_SAMPLES_PER_FRAME * m_scheduler.WorkerCount();
+
+        const double samples = m_frame_budget_seconds / m_seconds_per_sample;
+        return static_cast<uint32_t>(std::clamp(samples, double(MIN_SAMPLES_PER_FRAME), double(MAX_SAMPLES_PER_FRAME)));
+    }
+
+    uint32_t Renderer::TileOf(uint32_t pixel) const {
+        uint32_t x = pixel % m_film.Width();
+        uint32_t y = pixel / m_film.Width();
+        return (y / TILE_SIZE) * m_tiles_x + (x / TILE_SIZE);
+    }
+
+    void Renderer::RenderTile(Scene::Scene &scene, uint32_t tile) {
+        PROFILE_FUNCTION_AUTO();
+
+        uint32_t skipped = 0;
+        for (uint32_t k = m_tile_offsets[tile]; k < m_tile_offsets[tile + 1]; ++k) {
+            const FrameSample &sample = m_tile_samples[k];
+            uint32_t x = sample.pixel % m_film.Width();
+            uint32_t y = sample.pixel / m_film.Width();
+
+            // Tested here rather than when the frame is assembled: this worker has already added every
+            // earlier sample of the pixel, so the decision does not depend on how frames are cut
+            if (m_error_threshold > 0.0f && m_film.SampleCount(x, y) >= m_min_samples
+                && m_film.RelativeError(x, y) < m_error_threshold) {
+                skipped++;
+                continue;
+            }
+
+            // Keyed by the sample itself rather than by the worker, so the image does not depend on scheduling
+            Common::SampleRng rng { m_seed, sample.pixel, sample.index };
+            float ux = float(x) + rng.Next();
+            float uy = float(y) + rng.Next();
+            Geometry::Ray ray = scene.GetCamera().GenerateRay(ux, uy);
+            Color result_color = m_tracer->Trace(scene, ray, MAX_RAY_DEPTH);
+
+            // Pixels belong to exactly one tile, so only this worker touches them during the frame.
+            // The film only accumulates here, conversion to bytes is deferred until it is presented.
+            m_film.AddSample(x, y, result_color);
+        }
+
+        RAY_STATS_ADD(primary_rays, m_tile_offsets[tile + 1] - m_tile_offsets[tile] - skipped);
+        if (skipped > 0)
+            m_skipped_samples.fetch_add(skipped, std::memory_order_relaxed);
+    }
+
 }
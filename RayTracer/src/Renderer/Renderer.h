@@ -2,31 +2,120 @@
 
 #include "Film.h"
 #include "Geometry/Ray.h"
+#include "Platform/TaskScheduler.h"
+#include "Renderer/SampleSchedule.h"
 #include "Renderer/Tracer.h"
 #include "Scene/Scene.h"
+#include "Utils/RayStats.h"
+#include <algorithm>
+#include <atomic>
 
 namespace Renderer {
 
     class Renderer {
     public:
+        /** @brief Frame budgets for an interactive window and for renders that are never presented. */
+        static constexpr double DEFAULT_FRAME_BUDGET_MS = 16.0;
+        static constexpr double HEADLESS_FRAME_BUDGET_MS = 250.0;
+
         Renderer(uint32_t width, uint32_t height, VkFormat format, uint32_t samples_per_pixel, std::unique_ptr<Tracer> tracer);
         std::pair<Film &, bool> RenderToFilm(Scene::Scene &scene);
         Color Trace(Scene::Scene &scene, const Geometry::Ray &ray) const;
-    private:
-        Film m_film;
 
+        /**
+         * @brief Reseeds the sample order and the per-sample random numbers. Renders with the same
+         * seed are bit-identical regardless of the number of threads.
+         */
+        void SetSeed(uint32_t seed);
+
+        /** @brief Enables the progress bar and the statistics printed once the render completes. */
+        inline void SetVerbose(bool verbose) { m_verbose = verbose; }
+
+        /** @brief Replaces the tracer used for every camera sample. Call before the first frame. */
+        inline void SetTracer(std::unique_ptr<Tracer> tracer) { m_tracer = std::move(tracer); }
+
+        /**
+         * @brief Stops sampling a pixel once it has `min_samples` and the relative standard error of
+         * its mean luminance is below `threshold`. The samples per pixel become a budget for the whole
+         * film: the samples converged pixels leave unused go to further passes over the noisy ones, up to
+         * `ADAPTIVE_SAMPLE_SCALE` times the samples per pixel. A threshold of 0 disables it. Call before
+         * the first frame.
+         */
+        void SetAdaptiveSampling(float threshold, uint32_t min_samples = 16);
+
+        /**
+         * @brief Sizes every frame to take about `milliseconds`, from a running average of the time per
+         * sample of the previous frames. Short frames keep the window responsive; long ones amortize
+         * the per-frame overhead when nothing is presented.
+         */
+        inline void SetFrameBudget(double milliseconds) { m_frame_budget_seconds = milliseconds * 1e-3; }
+
+        /** @brief Worker pool of the renderer, also used to build the scene's acceleration structures. */
+        inline Platform::TaskScheduler &Scheduler() { return m_scheduler; }
+
+        /** @brief Selects the order in which samples are distributed over the film. Call before the first frame. */
+        inline void SetSampleOrder(SampleOrder order, uint32_t samples_per_pass = 1) { m_schedule.SetOrder(order, samples_per_pass); }
+
+        /** @brief Depth every camera ray is traced with. */
         static constexpr uint32_t MAX_RAY_DEPTH = 20;
 
+        /** @brief With adaptive sampling, the most samples a pixel can receive as a multiple of the samples per pixel. */
+        static constexpr uint32_t ADAPTIVE_SAMPLE_SCALE = 4;
+    private:
+        Film m_film;
+
         std::unique_ptr<Tracer> m_tracer;
 
-        uint32_t m_current_offset = 0;
-        static constexpr uint32_t SAMPLES_PER_FRAME = 500;
+        uint64_t m_current_offset = 0;
+
+        // Frame sizing: the first frame uses a fixed count per worker, later ones follow the measured cost
+        static constexpr uint32_t INITIAL_SAMPLES_PER_FRAME = 500;   // per worker
+        static constexpr uint32_t MIN_SAMPLES_PER_FRAME = 64;
+        static constexpr uint32_t MAX_SAMPLES_PER_FRAME = 1u << 22;
+        static constexpr double FRAME_COST_SMOOTHING = 0.25;         // weight of the newest frame
+        double m_frame_budget_seconds = DEFAULT_FRAME_BUDGET_MS * 1e-3;
+        double m_seconds_per_sample = 0.0;                           // 0 until a frame has been timed
+        static constexpr uint32_t TILE_SIZE = Film::TILE_SIZE;
 
         uint32_t m_samples_per_pixel;
-        std::vector<uint32_t> random_indices {};
+        SampleSchedule m_schedule;
+
+        Platform::TaskScheduler m_scheduler;
+        uint32_t m_seed = 0;
 
-        std::vector<Color> m_accum {};
-        std::vector<uint32_t> m_sample_count {};
+        // Adaptive sampling, disabled while the threshold is 0. The render ends at the first pass boundary
+        // where the traced samples reach the budget, which does not depend on how frames are cut
+        float m_error_threshold = 0.0f;
+        uint32_t m_min_samples = 16;
+        std::atomic<uint64_t> m_skipped_samples = 0;
+        bool m_budget_spent = false;
+
+        // A sample of the current frame: its pixel and how many samples that pixel received before it
+        struct FrameSample {
+            uint32_t pixel;
+            uint32_t index;
+        };
+
+        // The samples of the current frame bucketed by tile, so that every tile is owned by one task
+        uint32_t m_tiles_x = 0;
+        uint32_t m_tiles_y = 0;
+        std::vector<uint32_t> m_tile_offsets {};
+        std::vector<FrameSample> m_tile_samples {};
+        std::vector<FrameSample> m_frame_samples {};
+
+        // Counters at the start of the render and the time spent inside RenderToFilm since
+        Utils::RayCounts m_start_counts {};
+        Utils::RayCounts m_frame_counts {};
+        double m_render_seconds = 0.0;
+        bool m_verbose = true;
+    private:
+        /** @brief Samples to trace in the next frame to meet the frame budget. */
+        uint32_t FrameSampleCount() const;
+        /** @brief Samples traced so far, out of `SampleBudget`. */
+        uint64_t TracedSamples() const { return m_current_offset - m_skipped_samples.load(); }
+        uint64_t SampleBudget() const { return static_cast<uint64_t>(m_film.Width()) * m_film.Height() * m_samples_per_pixel; }
+        uint32_t TileOf(uint32_t pixel) const;
+        void RenderTile(Scene::Scene &scene, uint32_t tile);
     };
 
 }
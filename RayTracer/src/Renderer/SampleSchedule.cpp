@@ -0,0 +1,94 @@
+#include "Renderer/SampleSchedule.h"
+#include "Common/Hash.h"
+#include <algorithm>
+
+namespace Renderer {
+
+    namespace {
+        // Interleaves the lower 16 bits of x and y into a Z-order curve index
+        uint32_t MortonEncode(uint32_t x, uint32_t y) {
+            auto spread = [](uint32_t v) {
+                v &= 0x0000ffffu;
+                v = (v | (v << 8)) & 0x00ff00ffu;
+                v = (v | (v << 4)) & 0x0f0f0f0fu;
+                v = (v | (v << 2)) & 0x33333333u;
+                v = (v | (v << 1)) & 0x55555555u;
+                return v;
+            };
+            return spread(x) | (spread(y) << 1);
+        }
+    }
+
+    SampleSchedule::SampleSchedule(uint32_t width, uint32_t height, uint32_t samples_per_pixel, uint32_t seed, uint32_t tile_size)
+        : m_width(width)
+        , m_pixel_count(width * height)
+        , m_samples_per_pixel(samples_per_pixel)
+        , m_seed(seed)
+    {
+        const uint32_t tiles_x = (width + tile_size - 1) / tile_size;
+        const uint32_t tiles_y = (height + tile_size - 1) / tile_size;
+
+        std::vector<std::pair<uint32_t, Tile>> ordered;
+        ordered.reserve(tiles_x * tiles_y);
+        for (uint32_t ty = 0; ty < tiles_y; ++ty) {
+            for (uint32_t tx = 0; tx < tiles_x; ++tx) {
+                Tile tile { tx * tile_size, ty * tile_size, std::min(tile_size, width - tx * tile_size) };
+                ordered.push_back({ MortonEncode(tx, ty), tile });
+            }
+        }
+        std::sort(ordered.begin(), ordered.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        uint32_t start = 0;
+        for (const auto &[code, tile] : ordered) {
+            m_tiles.push_back(tile);
+            m_tile_starts.push_back(start);
+            start += tile.width * std::min(tile_size, height - tile.y);
+        }
+        m_tile_starts.push_back(start);
+    }
+
+    void SampleSchedule::SetOrder(SampleOrder order, uint32_t samples_per_pass) {
+        m_order = order;
+        m_samples_per_pass = std::max(samples_per_pass, 1u);
+    }
+
+    uint32_t SampleSchedule::PixelAt(uint64_t sample) const {
+        if (m_order == SampleOrder::Random) {
+            uint32_t pass = static_cast<uint32_t>(sample / m_pixel_count);
+            uint32_t index = static_cast<uint32_t>(sample % m_pixel_count);
+            return Common::Permute(index, m_pixel_count, Common::HashCombine(m_seed, pass));
+        }
+
+        // All passes hold m_samples_per_pass samples per pixel except a possibly shorter last one
+        const uint64_t pass_size = static_cast<uint64_t>(m_pixel_count) * m_samples_per_pass;
+        const uint32_t pass = static_cast<uint32_t>(sample / pass_size);
+        const uint32_t samples_in_pass = std::min(m_samples_per_pass, m_samples_per_pixel - pass * m_samples_per_pass);
+        const uint64_t local = sample - pass * pass_size;
+
+        return TiledPixelAt(static_cast<uint32_t>(local / samples_in_pass));
+    }
+
+    uint32_t SampleSchedule::SampleIndexAt(uint64_t sample) const {
+        if (m_order == SampleOrder::Random)
+            return static_cast<uint32_t>(sample / m_pixel_count);
+
+        const uint64_t pass_size = static_cast<uint64_t>(m_pixel_count) * m_samples_per_pass;
+        const uint32_t pass = static_cast<uint32_t>(sample / pass_size);
+        const uint32_t samples_in_pass = std::min(m_samples_per_pass, m_samples_per_pixel - pass * m_samples_per_pass);
+        const uint64_t local = sample - pass * pass_size;
+
+        return pass * m_samples_per_pass + static_cast<uint32_t>(local % samples_in_pass);
+    }
+
+    uint32_t SampleSchedule::TiledPixelAt(uint32_t position) const {
+        auto next = std::upper_bound(m_tile_starts.begin(), m_tile_starts.end(), position);
+        uint32_t tile_index = static_cast<uint32_t>(next - m_tile_starts.begin()) - 1;
+
+        const Tile &tile = m_tiles[tile_index];
+        uint32_t offset = position - m_tile_starts[tile_index];
+        uint32_t x = tile.x + offset % tile.width;
+        uint32_t y = tile.y + offset / tile.width;
+        return y * m_width + x;
+    }
+
+}
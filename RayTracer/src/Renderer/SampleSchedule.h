@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Renderer {
+
+    enum class SampleOrder {
+        Random,     // every pass visits the pixels in a hashed permutation
+        Tiled       // every pass walks tiles in Morton order and pixels within a tile in scanline order
+    };
+
+    /**
+     * @brief Decides which pixel receives the n-th sample of a render without storing the order.
+     *
+     * Samples are issued in progressive passes: every pass visits each pixel once (or
+     * `samples_per_pass` times in a row in tiled order). The order is recomputed on the fly,
+     * so memory use does not depend on the sample count.
+     */
+    class SampleSchedule {
+    public:
+        SampleSchedule(uint32_t width, uint32_t height, uint32_t samples_per_pixel, uint32_t seed, uint32_t tile_size);
+
+        inline uint64_t TotalSamples() const { return static_cast<uint64_t>(m_pixel_count) * m_samples_per_pixel; }
+        inline void SetSeed(uint32_t seed) { m_seed = seed; }
+        /** @brief Changes how many samples every pixel is scheduled for. Call before the first sample is looked up. */
+        inline void SetSamplesPerPixel(uint32_t samples_per_pixel) { m_samples_per_pixel = samples_per_pixel; }
+        inline SampleOrder Order() const { return m_order; }
+
+        /**
+         * @brief Selects the traversal order. Tiled order keeps consecutive samples spatially
+         * coherent and traces `samples_per_pass` samples of a pixel back to back.
+         */
+        void SetOrder(SampleOrder order, uint32_t samples_per_pass = 1);
+
+        /** @brief Samples in one pass over the film; passes begin at multiples of it, only the last may be shorter. */
+        inline uint64_t PassSize() const {
+            return static_cast<uint64_t>(m_pixel_count) * (m_order == SampleOrder::Tiled ? m_samples_per_pass : 1);
+        }
+
+        /** @brief Pixel index (y * width + x) of the given sample. */
+        uint32_t PixelAt(uint64_t sample) const;
+
+        /** @brief How many samples the pixel of `sample` has received before it, in [0, samples_per_pixel). */
+        uint32_t SampleIndexAt(uint64_t sample) const;
+    private:
+        uint32_t m_width;
+        uint32_t m_pixel_count;
+        uint32_t m_samples_per_pixel;
+        uint32_t m_seed;
+
+        SampleOrder m_order = SampleOrder::Random;
+        uint32_t m_samples_per_pass = 1;
+
+        // Tiled order: tile origins in Morton order and the first in-pass pixel of each tile
+        struct Tile { uint32_t x, y, width; };
+        std::vector<Tile> m_tiles {};
+        std::vector<uint32_t> m_tile_starts {};
+    private:
+        uint32_t TiledPixelAt(uint32_t position) const;
+    };
+
+}
@@ -9,7 +9,7 @@ namespace Renderer {
             return intersection->Material()->Shade(*intersection, scene, ray, *this, depth);
         }
 
-        return glm::vec4(0.6f, 0.6f, 0.8f, 1.0f);
+        return scene.GetBackgroundColor();
     }
 
 }
@@ -1,5 +1,4 @@
 #include "Scene.h"
-#include "Materials/Dielectric.h"
 
 namespace Scene {
 
@@ -14,19 +13,16 @@ namespace Scene {
 
         for (const auto &light : m_lights) {
             auto [shadow_ray, max_dist] = light->ComputeShadowRay(point);
-            auto blocker = IntersectNearest(shadow_ray);
-
-            if (!blocker || blocker->Time() > max_dist) {
-                result += light->Illuminate(point, normal);
-            } else {
-                if (auto die = dynamic_cast<const Materials::Dielectric *>(blocker->Material())) {
-                    float eta = 1.0f / die->GetIndexOfRefraction();
-                    float reflectance = die->ComputeReflectance(shadow_ray.Direction(), blocker->Normal(), eta);
-                    float beer_falloff = std::exp(-die->GetAbsorption() * blocker->Time());
-                    float transmittance = (1.0f - reflectance) * beer_falloff;
-                    result += (die->GetDiffuseRatio() + (1.0f - die->GetDiffuseRatio()) * transmittance) * light->Illuminate(point, normal);
-                }
-            }
+            RAY_STATS_INC(shadow_rays);
+
+            // Opaque blockers end the traversal at once, glass panes along the way each attenuate. An opaque
+            // object behind glass is therefore in full shadow, unlike the old nearest-hit test that only saw the glass.
+            // Without translucent primitives the plain occlusion query gives the same answer
+            const float transmittance = m_primitive_list.HasTranslucentPrimitives()
+                ? Transmittance(shadow_ray, 0.0f, max_dist)
+                : (Occluded(shadow_ray, 0.0f, max_dist) ? 0.0f : 1.0f);
+            if (transmittance > 0.0f)
+                result += transmittance * light->Illuminate(point, normal);
         }
 
         
@@ -7,6 +7,7 @@
 #include "Geometry/Primitive.h"
 #include "Scene/PointLight.h"
 #include "Utils/Profiler.h"
+#include "Utils/RayStats.h"
 #include <vector>
 
 namespace Scene {
@@ -28,15 +29,47 @@ namespace Scene {
             m_primitive_list.Add(std::make_unique<T>(std::forward<Args>(args)...));
         }
 
+        /** @brief Builds the acceleration structures, on the scheduler's workers if given. Call once the scene is fully populated. */
+        inline void Build(Platform::TaskScheduler *scheduler = nullptr) { m_primitive_list.Build(scheduler); }
+
+        /** @brief Bytes held by all acceleration structures of the scene, valid after `Build`. */
+        inline size_t AccelerationStructureBytes() const { return m_primitive_list.AccelerationStructureBytes(); }
+
         inline std::optional<Geometry::Intersection> IntersectNearest(
             const Geometry::Ray &ray, 
             float tmin = 0,
-            float tmax = std::numeric_limits<float>::infinity()) const { PROFILE_FUNCTION_AUTO(); return m_primitive_list.IntersectNearest(ray, tmin, tmax); };
+            float tmax = std::numeric_limits<float>::infinity()) const {
+            PROFILE_FUNCTION_AUTO();
+            auto intersection = m_primitive_list.IntersectNearest(ray, tmin, tmax);
+            if (intersection) RAY_STATS_INC(hits);
+            return intersection;
+        }
 
         inline std::optional<Geometry::Intersection> IntersectAny(
             const Geometry::Ray &ray, 
             float tmin = 0,
-            float tmax = std::numeric_limits<float>::infinity()) const { PROFILE_FUNCTION_AUTO(); return m_primitive_list.IntersectAny(ray, tmin, tmax); };
+            float tmax = std::numeric_limits<float>::infinity()) const {
+            PROFILE_FUNCTION_AUTO();
+            auto intersection = m_primitive_list.IntersectAny(ray, tmin, tmax);
+            if (intersection) RAY_STATS_INC(hits);
+            return intersection;
+        }
+
+        /** @brief Whether an opaque surface lies on the ray within [tmin, tmax]; translucent ones are ignored. */
+        inline bool Occluded(const Geometry::Ray &ray, float tmin, float tmax) const {
+            PROFILE_FUNCTION_AUTO();
+            const bool occluded = m_primitive_list.Occluded(ray, tmin, tmax);
+            if (occluded) RAY_STATS_INC(hits);
+            return occluded;
+        }
+
+        /** @brief Fraction of light passing along the ray within [tmin, tmax], see `PrimitiveList::Transmittance`. */
+        inline float Transmittance(const Geometry::Ray &ray, float tmin, float tmax) const {
+            PROFILE_FUNCTION_AUTO();
+            const float transmittance = m_primitive_list.Transmittance(ray, tmin, tmax);
+            if (transmittance < 1.0f) RAY_STATS_INC(hits);
+            return transmittance;
+        }
 
         template <class T, class... Args>
         void AddLight(Args &&...args) {
@@ -44,9 +77,14 @@ namespace Scene {
             m_lights.push_back(std::make_unique<T>(std::forward<Args>(args)...));
         }
 
+        /**
+         * @brief Light arriving at `point` from all lights. Shadow rays account for every blocker up to the light,
+         * not only the nearest one: an opaque surface behind glass blocks the light completely.
+         */
         Color DirectIllumination(const glm::vec3 &point, const glm::vec3 &normal) const;
 
         static Color GetAmbientColor() { return { 0.1f, 0.1f, 0.1f, 1.0f }; }
+        static Color GetBackgroundColor() { return { 0.6f, 0.6f, 0.8f, 1.0f }; }
     private:
         std::shared_ptr<Camera> m_camera;
         Geometry::PrimitiveList m_primitive_list;
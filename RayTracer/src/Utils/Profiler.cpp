@@ -1,76 +1,417 @@
 #include "Utils/Profiler.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
 
 namespace Utils {
-    
+
     /* ---------- static storage ---------- */
-    std::unordered_map<
-        ProfileCategory,
-        std::unordered_map<std::string, std::vector<ProfileSample>>
-    > Profiler::s_records;
-    
-    std::mutex Profiler::s_mutex;
-    
-    /* ---------- ctor / dtor measure duration ---------- */
-    Profiler::Profiler(std::string_view name, ProfileCategory cat)
-        : m_category{cat}, m_name{name},
-          m_start{Clock::now()}
-    {}
-    
-    Profiler::~Profiler()
+    namespace {
+
+        struct SectionInfo
+        {
+            std::string     name;
+            ProfileCategory category;
+        };
+
+        /* Section names and every thread's block. Only touched when a section or a thread is seen
+           for the first time, and by the summary. Blocks outlive their threads so that nothing
+           recorded by a finished worker is lost. */
+        struct Registry
+        {
+            std::mutex                                      mutex;
+            std::vector<SectionInfo>                        sections;
+            std::vector<std::unique_ptr<ProfileThreadData>> blocks;
+        };
+
+        Registry &GetRegistry()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        /* Reference points for converting ticks to nanoseconds */
+        const auto     s_clock_origin = std::chrono::steady_clock::now();
+        const uint64_t s_tick_origin  = Profiler::Now();
+
+        void WriteJsonString(std::ostream &out, std::string_view text)
+        {
+            out << '"';
+            for (char c : text) {
+                if (c == '"' || c == '\\') out << '\\' << c;
+                else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+                else out << c;
+            }
+            out << '"';
+        }
+
+    }
+
+    /* ---------- hardware counters ---------- */
+    namespace {
+
+    #ifdef __linux__
+        int OpenCounter(uint64_t config, int group_fd)
+        {
+            perf_event_attr attr {};
+            attr.size           = sizeof(attr);
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.config         = config;
+            attr.read_format    = PERF_FORMAT_GROUP;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+
+            // pid 0 / cpu -1: follow the calling thread on whatever core it runs
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+        }
+    #endif
+
+        void CloseCounters(ProfileThreadData &data)
+        {
+        #ifdef __linux__
+            for (int &fd : data.counter_fds) {
+                if (fd >= 0) close(fd);
+                fd = -1;
+            }
+        #endif
+        }
+
+        bool OpenCounters(ProfileThreadData &data)
+        {
+        #ifdef __linux__
+            constexpr uint64_t configs[PROFILE_COUNTER_COUNT] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+            };
+
+            for (uint32_t i = 0; i < PROFILE_COUNTER_COUNT; ++i) {
+                data.counter_fds[i] = OpenCounter(configs[i], i == 0 ? -1 : data.counter_fds[0]);
+                if (data.counter_fds[i] < 0) {
+                    CloseCounters(data);
+                    data.counters_unavailable = true;
+                    return false;
+                }
+            }
+            return true;
+        #else
+            data.counters_unavailable = true;
+            return false;
+        #endif
+        }
+
+    }
+
+    ProfileThreadData::~ProfileThreadData()
+    {
+        CloseCounters(*this);
+    }
+
+    bool Profiler::ReadCounters(uint64_t (&values)[PROFILE_COUNTER_COUNT])
+    {
+    #ifdef __linux__
+        ProfileThreadData *data = t_data ? t_data : AcquireThreadData();
+        if (data->counters_unavailable) return false;
+        if (data->counter_fds[0] < 0 && !OpenCounters(*data)) return false;
+
+        struct { uint64_t nr; uint64_t values[PROFILE_COUNTER_COUNT]; } group;
+        if (read(data->counter_fds[0], &group, sizeof(group)) != static_cast<ssize_t>(sizeof(group)) || group.nr != PROFILE_COUNTER_COUNT)
+            return false;
+
+        std::copy(std::begin(group.values), std::end(group.values), std::begin(values));
+        return true;
+    #else
+        (void)values;
+        return false;
+    #endif
+    }
+
+    void Profiler::RecordCounters()
+    {
+        uint64_t end[PROFILE_COUNTER_COUNT];
+        if (!ReadCounters(end)) return;
+
+        constexpr auto relaxed = std::memory_order_relaxed;
+        ProfileAggregate &agg = t_data->sections[m_section];
+        agg.counted.store(agg.counted.load(relaxed) + 1, relaxed);
+        for (uint32_t i = 0; i < PROFILE_COUNTER_COUNT; ++i)
+            agg.counters[i].store(agg.counters[i].load(relaxed) + (end[i] - m_counters[i]), relaxed);
+    }
+
+    bool Profiler::EnableHardwareCounters()
+    {
+        uint64_t probe[PROFILE_COUNTER_COUNT];
+        if (!ReadCounters(probe)) {
+            std::cerr << "Profiler: hardware counters are unavailable, continuing with timings only" << std::endl;
+            return false;
+        }
+
+        s_counters_enabled.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    thread_local ProfileThreadData *Profiler::t_data = nullptr;
+    std::atomic<uint32_t> Profiler::s_trace_capacity { 0 };
+    std::atomic<uint64_t> Profiler::s_trace_min_ticks { 0 };
+    std::atomic<bool>     Profiler::s_counters_enabled { false };
+
+    uint32_t Profiler::RegisterSection(std::string_view name, ProfileCategory cat)
+    {
+        Registry &registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+
+        for (uint32_t id = 0; id < registry.sections.size(); ++id)
+            if (registry.sections[id].category == cat && registry.sections[id].name == name)
+                return id;
+
+        if (registry.sections.size() == MAX_SECTIONS)
+            throw std::runtime_error("Profiler: too many sections, raise Profiler::MAX_SECTIONS");
+
+        registry.sections.push_back({ std::string(name), cat });
+        return static_cast<uint32_t>(registry.sections.size() - 1);
+    }
+
+    ProfileThreadData *Profiler::AcquireThreadData()
     {
-        const auto dur = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                            Clock::now() - m_start).count();
-        logRecord(m_category, m_name, dur);
-    }
-    
-    /* ---------- static helpers ---------- */
-    void Profiler::logRecord(ProfileCategory cat,
-                             const std::string& name,
-                             long long ns)
+        Registry &registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+
+        t_data = registry.blocks.emplace_back(std::make_unique<ProfileThreadData>()).get();
+        t_data->thread_index = static_cast<uint32_t>(registry.blocks.size() - 1);
+        return t_data;
+    }
+
+    void Profiler::AllocateHistogram(ProfileAggregate &aggregate)
+    {
+        std::lock_guard lock(GetRegistry().mutex);
+        aggregate.buckets = std::make_unique<std::array<std::atomic<uint64_t>, ProfileHistogram::BUCKET_COUNT>>();
+    }
+
+    void Profiler::AllocateTraceBuffer(ProfileThreadData &data, uint32_t capacity)
+    {
+        std::lock_guard lock(GetRegistry().mutex);
+        data.events = std::make_unique<ProfileTraceEvent[]>(capacity);
+        data.event_mask = capacity - 1;
+    }
+
+    void Profiler::EnableTracing(uint32_t events_per_thread, uint32_t min_duration_ns)
+    {
+        const double ns_per_tick = TicksToNanoseconds(1u << 20) / double(1u << 20);
+        s_trace_min_ticks.store(static_cast<uint64_t>(min_duration_ns / ns_per_tick), std::memory_order_relaxed);
+
+        // Power of two so that the ring index is a mask
+        s_trace_capacity.store(std::bit_ceil(std::max(events_per_thread, 2u)), std::memory_order_relaxed);
+    }
+
+    void Profiler::SetThreadName(std::string_view name)
+    {
+        ProfileThreadData *data = t_data ? t_data : AcquireThreadData();
+        std::lock_guard lock(GetRegistry().mutex);
+        data->thread_name = name;
+    }
+
+    double Profiler::TicksToNanoseconds(uint64_t ticks)
     {
-        std::lock_guard lock(s_mutex);
-        s_records[cat][name].push_back({ ns });
-    
-    #ifdef UTILS_ProfileVerbose
-        Logger::Log(Logger::Level::Profile,
-                    "({}) {}",
-                    name,
-                    formatDuration(ns));
+    #if defined(__x86_64__) || defined(__i386__)
+        // Calibrate the time stamp counter against the steady clock over the whole run so far
+        auto elapsed = std::chrono::steady_clock::now() - s_clock_origin;
+        if (elapsed < std::chrono::milliseconds(10)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+            elapsed = std::chrono::steady_clock::now() - s_clock_origin;
+        }
+
+        const double elapsed_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        const double elapsed_ticks = static_cast<double>(Now() - s_tick_origin);
+        return static_cast<double>(ticks) * (elapsed_ns / elapsed_ticks);
+    #else
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::duration(ticks)).count());
     #endif
     }
-    
+
     void Profiler::LogSummary()
     {
-        std::lock_guard lock(s_mutex);
+        const double ns_per_tick = TicksToNanoseconds(1u << 20) / double(1u << 20);
+
+        Registry &registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+
+        /* ---------- merge the per-thread blocks ---------- */
+        struct Merged
+        {
+            uint64_t count = 0, ticks = 0, min_ticks = std::numeric_limits<uint64_t>::max(), max_ticks = 0;
+            std::array<uint64_t, ProfileHistogram::BUCKET_COUNT> buckets {};
+            uint64_t counted = 0;
+            std::array<uint64_t, PROFILE_COUNTER_COUNT> counters {};
+
+            /* Midpoint of the bucket holding the requested rank, clamped to the exact extremes */
+            uint64_t Percentile(double p) const
+            {
+                const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * double(count))));
+                uint64_t seen = 0;
+                for (uint32_t b = 0; b < ProfileHistogram::BUCKET_COUNT; ++b) {
+                    seen += buckets[b];
+                    if (seen >= rank) {
+                        const uint64_t lower = ProfileHistogram::LowerBound(b);
+                        const uint64_t upper = b + 1 < ProfileHistogram::BUCKET_COUNT ? ProfileHistogram::LowerBound(b + 1) : max_ticks + 1;
+                        return std::clamp(lower + (upper - lower) / 2, min_ticks, max_ticks);
+                    }
+                }
+                return max_ticks;
+            }
+        };
+        std::vector<Merged> merged(registry.sections.size());
+
+        constexpr auto relaxed = std::memory_order_relaxed;
+        for (auto &block : registry.blocks) {
+            for (uint32_t id = 0; id < merged.size(); ++id) {
+                const ProfileAggregate &agg = block->sections[id];
+                merged[id].count    += agg.count.load(relaxed);
+                merged[id].ticks    += agg.ticks.load(relaxed);
+                merged[id].min_ticks = std::min(merged[id].min_ticks, agg.min_ticks.load(relaxed));
+                merged[id].max_ticks = std::max(merged[id].max_ticks, agg.max_ticks.load(relaxed));
+                if (agg.buckets) {
+                    for (uint32_t b = 0; b < ProfileHistogram::BUCKET_COUNT; ++b)
+                        merged[id].buckets[b] += (*agg.buckets)[b].load(relaxed);
+                }
+                merged[id].counted += agg.counted.load(relaxed);
+                for (uint32_t i = 0; i < PROFILE_COUNTER_COUNT; ++i)
+                    merged[id].counters[i] += agg.counters[i].load(relaxed);
+            }
+        }
+
         std::ostringstream out;
-    
         out << "\n----- Profiler Summary -----\n";
-    
-        for (auto& [cat, sections] : s_records)
+
+        for (uint8_t c = 0; c <= static_cast<uint8_t>(ProfileCategory::Misc); ++c)
         {
-            out << "\n[" << categoryToString(cat) << "]\n";
-            out << std::string(70, '-') << '\n';
-    
-            for (auto& [name, vec] : sections)
+            const auto cat = static_cast<ProfileCategory>(c);
+            bool header = false;
+
+            for (uint32_t id = 0; id < merged.size(); ++id)
             {
-                long long total = 0;
-                for (auto& s : vec) total += s.duration;
-    
-                long long avg = total / static_cast<long long>(vec.size());
-    
-                out << std::setw(36) << std::left << name
-                    << "  runs: " << std::setw(6) << vec.size()
-                    << "  avg: "  << std::setw(12) << formatDuration(avg)
-                    << "  total: " << formatDuration(total)
+                if (registry.sections[id].category != cat || merged[id].count == 0)
+                    continue;
+
+                if (!header) {
+                    out << "\n[" << categoryToString(cat) << "]\n";
+                    out << std::string(150, '-') << '\n';
+                    header = true;
+                }
+
+                const auto ns = [&](uint64_t ticks) { return static_cast<long long>(double(ticks) * ns_per_tick); };
+                const Merged &m = merged[id];
+
+                out << std::setw(36) << std::left << registry.sections[id].name
+                    << "  runs: " << std::setw(8) << m.count
+                    << "  avg: "  << std::setw(9) << formatDuration(ns(m.ticks / m.count))
+                    << "  min: "  << std::setw(9) << formatDuration(ns(m.min_ticks))
+                    << "  p50: "  << std::setw(9) << formatDuration(ns(m.Percentile(0.50)))
+                    << "  p90: "  << std::setw(9) << formatDuration(ns(m.Percentile(0.90)))
+                    << "  p99: "  << std::setw(9) << formatDuration(ns(m.Percentile(0.99)))
+                    << "  max: "  << std::setw(9) << formatDuration(ns(m.max_ticks))
+                    << "  total: " << formatDuration(ns(m.ticks))
                     << '\n';
+
+                if (m.counted > 0) {
+                    const auto per_call = [&](ProfileCounter counter) { return double(m.counters[static_cast<uint32_t>(counter)]) / double(m.counted); };
+                    const double cycles = per_call(ProfileCounter::Cycles);
+                    const double instructions = per_call(ProfileCounter::Instructions);
+
+                    out << std::setw(36) << ""
+                        << std::fixed << std::setprecision(1)
+                        << "  cycles/call: " << std::setw(9) << cycles
+                        << "  IPC: " << std::setprecision(2) << (cycles > 0.0 ? instructions / cycles : 0.0)
+                        << "  LLC misses/call: " << std::setprecision(3) << per_call(ProfileCounter::CacheMisses)
+                        << "  branch misses/call: " << per_call(ProfileCounter::BranchMisses)
+                        << std::defaultfloat << '\n';
+                }
             }
         }
        std::cout << out.str();
     }
-    
+
+    void Profiler::WriteChromeTrace(const std::string &path)
+    {
+        const double ns_per_tick = TicksToNanoseconds(1u << 20) / double(1u << 20);
+
+        std::ofstream out(path);
+        if (!out)
+            throw std::runtime_error("Profiler: could not open trace file " + path);
+
+        Registry &registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+
+        const auto micros = [&](uint64_t ticks) { return double(ticks) * ns_per_tick * 1e-3; };
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool first = true;
+        for (auto &block : registry.blocks)
+        {
+            const uint32_t tid = block->thread_index;
+            const std::string name = block->thread_name.empty() ? "Thread " + std::to_string(tid) : block->thread_name;
+
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+            WriteJsonString(out, name);
+            out << "}}";
+            first = false;
+
+            if (!block->events)
+                continue;
+
+            /* The owner may still be appending: copy the ring, then drop whatever could have been
+               overwritten in the meantime (including the slot being written right now). */
+            const uint64_t capacity = uint64_t(block->event_mask) + 1;
+            const uint64_t head = block->event_head.load(std::memory_order_acquire);
+            const uint64_t begin = head > capacity ? head - capacity : 0;
+
+            struct Event { uint64_t section, start, end; };
+            std::vector<Event> events;
+            events.reserve(head - begin);
+            for (uint64_t i = begin; i < head; ++i) {
+                const ProfileTraceEvent &event = block->events[i & block->event_mask];
+                events.push_back({ event.section.load(std::memory_order_relaxed),
+                                   event.start.load(std::memory_order_relaxed),
+                                   event.end.load(std::memory_order_relaxed) });
+            }
+
+            const uint64_t head_after = block->event_head.load(std::memory_order_acquire);
+            const uint64_t valid_begin = head_after + 1 > capacity ? head_after + 1 - capacity : 0;
+
+            for (uint64_t i = std::max(begin, valid_begin); i < head; ++i)
+            {
+                const Event &event = events[i - begin];
+                const SectionInfo &section = registry.sections[event.section];
+
+                out << ",\n{\"ph\":\"X\",\"name\":";
+                WriteJsonString(out, section.name);
+                out << ",\"cat\":\"" << categoryToString(section.category) << "\""
+                    << ",\"ts\":" << micros(event.start - s_tick_origin)
+                    << ",\"dur\":" << micros(event.end - event.start)
+                    << ",\"pid\":1,\"tid\":" << tid << '}';
+            }
+        }
+
+        out << "\n]}\n";
+        if (!out)
+            throw std::runtime_error("Profiler: failed to write trace file " + path);
+    }
+
     /* ---------- formatting + category names ---------- */
     auto Profiler::formatDuration(long long nanoseconds) -> std::string {
       std::ostringstream oss;
@@ -86,7 +427,7 @@ namespace Utils {
       }
       return oss.str();
     }
-    
+
     std::string Profiler::categoryToString(ProfileCategory c)
     {
         switch (c)
@@ -1,15 +1,24 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <chrono>
-#include <mutex>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <string>
-#include <unordered_map>
-#include <vector>
+#include <string_view>
 #include "Common/defs.h"
 #include "Common/NonCopyable.h"
 #include "Common/NonMovable.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
 namespace Utils {
-    
+
     /* ---------------- domain-specific categories ---------------- */
     enum class ProfileCategory : uint8_t
     {
@@ -20,41 +29,228 @@ namespace Utils {
         Vulkan,            // command-buffer / queue submits
         Misc               // anything else
     };
-    
-    /* --------- one record = one timing event (nanoseconds) ------ */
-    struct ProfileSample { long long duration; };
-    
+
+    /**
+     * @brief Log-linear bucketing of durations (HDR-histogram style): every power of two is split
+     * into 2^SUB_BITS equal buckets, so a bucket is at most 12.5% of its value wide whatever the
+     * magnitude. Durations of 2^MAX_EXPONENT ticks and beyond share the last bucket.
+     */
+    struct ProfileHistogram
+    {
+        static constexpr uint32_t SUB_BITS     = 3;
+        static constexpr uint32_t SUB_COUNT    = 1u << SUB_BITS;
+        static constexpr uint32_t MAX_EXPONENT = 40;
+        static constexpr uint32_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BITS + 1) * SUB_COUNT;
+
+        static inline uint32_t BucketOf(uint64_t ticks)
+        {
+            ticks = std::min(ticks, (uint64_t(1) << MAX_EXPONENT) - 1);
+            if (ticks < SUB_COUNT) return static_cast<uint32_t>(ticks);
+
+            const uint32_t exponent = 63 - std::countl_zero(ticks);
+            const uint32_t sub = static_cast<uint32_t>(ticks >> (exponent - SUB_BITS)) & (SUB_COUNT - 1);
+            return (exponent - SUB_BITS + 1) * SUB_COUNT + sub;
+        }
+
+        /** @brief Smallest duration that falls into `bucket`. */
+        static inline uint64_t LowerBound(uint32_t bucket)
+        {
+            if (bucket < SUB_COUNT) return bucket;
+
+            const uint32_t exponent = bucket / SUB_COUNT + SUB_BITS - 1;
+            return uint64_t(SUB_COUNT + bucket % SUB_COUNT) << (exponent - SUB_BITS);
+        }
+    };
+
+    /* ---------- hardware counters sampled around each scope ---------- */
+    enum class ProfileCounter : uint8_t
+    {
+        Cycles = 0,
+        Instructions,
+        CacheMisses,       // last-level cache
+        BranchMisses,
+        Count
+    };
+
+    static constexpr uint32_t PROFILE_COUNTER_COUNT = static_cast<uint32_t>(ProfileCounter::Count);
+
+    /* ------- fixed-size aggregate of one section on one thread ------- */
+    struct ProfileAggregate
+    {
+        // Only the owning thread writes, relaxed atomics merely keep concurrent summaries well defined
+        std::atomic<uint64_t> count     { 0 };
+        std::atomic<uint64_t> ticks     { 0 };
+        std::atomic<uint64_t> min_ticks { std::numeric_limits<uint64_t>::max() };
+        std::atomic<uint64_t> max_ticks { 0 };
+
+        // ~2.4 KB, allocated on the section's first scope on this thread so that unused sections cost nothing
+        std::unique_ptr<std::array<std::atomic<uint64_t>, ProfileHistogram::BUCKET_COUNT>> buckets;
+
+        // Only scopes that ran with hardware counters contribute here
+        std::atomic<uint64_t> counted   { 0 };
+        std::array<std::atomic<uint64_t>, PROFILE_COUNTER_COUNT> counters {};
+    };
+
+    /* ------------ one begin/end pair kept for trace export ----------- */
+    struct ProfileTraceEvent
+    {
+        std::atomic<uint64_t> section { 0 };
+        std::atomic<uint64_t> start   { 0 };
+        std::atomic<uint64_t> end     { 0 };
+    };
+
+    struct ProfileThreadData;
+
+    /**
+     * @brief Scoped timer for a pre-registered section.
+     *
+     * Sections are interned once per call site by the PROFILE_* macros, after which a scope costs
+     * two timestamp reads and a handful of uncontended stores into the calling thread's own block.
+     * A thread's block holds the fixed-size aggregates of every section (about 10 KB); the duration
+     * histogram of a section is added on its first scope on that thread. After that no locks are
+     * taken and no memory is allocated.
+     *
+     * While tracing is enabled every scope is additionally appended to a per-thread ring buffer,
+     * which `WriteChromeTrace` exports in the Chrome Trace Event format (chrome://tracing, Perfetto).
+     *
+     * With hardware counters enabled each scope also reads the thread's perf_event group on entry
+     * and exit. That costs two system calls per scope, so it is meant for targeted investigations
+     * rather than for leaving on.
+     */
     class Profiler : private NonCopyable, private NonMovable
     {
     public:
-        Profiler(std::string_view section,
-                 ProfileCategory category = ProfileCategory::Misc);
-        ~Profiler();
-    
+        static constexpr uint32_t MAX_SECTIONS = 128;
+
+        explicit Profiler(uint32_t section)
+            : m_section{section}
+        {
+            if (s_counters_enabled.load(std::memory_order_relaxed)) [[unlikely]]
+                m_counting = ReadCounters(m_counters);
+            m_start = Now();
+        }
+
+        ~Profiler()
+        {
+            const uint64_t end = Now();
+            if (m_counting) [[unlikely]]
+                RecordCounters();
+            Record(m_section, m_start, end);
+        }
+
+        /** @brief Interns `section`, sections with the same name and category share one id. */
+        static uint32_t RegisterSection(std::string_view section,
+                                        ProfileCategory category = ProfileCategory::Misc);
+
         static void LogSummary();  /* call once on exit */
-    
+
+        /**
+         * @brief Starts recording individual scopes, each thread keeps its latest `events_per_thread`.
+         * Scopes shorter than `min_duration_ns` only count towards the summary, so that per-ray
+         * sections do not push whole frames out of the ring.
+         */
+        static void EnableTracing(uint32_t events_per_thread = 1u << 16, uint32_t min_duration_ns = 1000);
+
+        /** @brief Writes the recorded scopes as Chrome Trace Event JSON. Throws if the file cannot be written. */
+        static void WriteChromeTrace(const std::string &path);
+
+        /**
+         * @brief Samples cycles, instructions, LLC misses and branch misses around every scope from
+         * now on (Linux perf_event_open). Returns false and leaves profiling unchanged when the
+         * counters cannot be opened, e.g. on other platforms or under a restrictive perf_event_paranoid.
+         */
+        static bool EnableHardwareCounters();
+
+        /** @brief Names the calling thread in exported traces. */
+        static void SetThreadName(std::string_view name);
+
+        /** @brief Raw timestamp in ticks, see `TicksToNanoseconds`. */
+        static inline uint64_t Now()
+        {
+        #if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+        #else
+            return static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+        #endif
+        }
+
+        static double TicksToNanoseconds(uint64_t ticks);
+
     private:
-        using Clock      = std::chrono::high_resolution_clock;
-        using TimePoint  = std::chrono::time_point<Clock>;
-    
-        ProfileCategory m_category;
-        std::string     m_name;
-        TimePoint       m_start;
-    
-        static std::unordered_map<
-                  ProfileCategory,
-                  std::unordered_map<std::string, std::vector<ProfileSample>>
-               > s_records;
-        static std::mutex s_mutex;
-    
-        static void logRecord(ProfileCategory cat,
-                              const std::string& name,
-                              long long duration);
-    
+        using Clock = std::chrono::steady_clock;
+
+        uint32_t m_section;
+        uint64_t m_start;
+        bool     m_counting = false;
+        uint64_t m_counters[PROFILE_COUNTER_COUNT];
+
+        static thread_local ProfileThreadData *t_data;
+        static std::atomic<uint32_t> s_trace_capacity;   // 0 while tracing is off
+        static std::atomic<uint64_t> s_trace_min_ticks;
+        static std::atomic<bool>     s_counters_enabled;
+
+        static inline void Record(uint32_t section, uint64_t start, uint64_t end);
+
+        static ProfileThreadData *AcquireThreadData();
+        static void AllocateHistogram(ProfileAggregate &aggregate);
+        static void AllocateTraceBuffer(ProfileThreadData &data, uint32_t capacity);
+
+        static bool ReadCounters(uint64_t (&values)[PROFILE_COUNTER_COUNT]);
+        void RecordCounters();
+
         static std::string categoryToString(ProfileCategory);
         static std::string formatDuration(long long ns);
     };
 
+    struct ProfileThreadData
+    {
+        std::array<ProfileAggregate, Profiler::MAX_SECTIONS> sections;
+
+        /* trace ring buffer, allocated once tracing is enabled */
+        uint32_t                             thread_index = 0;
+        std::string                          thread_name;
+        std::unique_ptr<ProfileTraceEvent[]> events;
+        uint32_t                             event_mask = 0;
+        std::atomic<uint64_t>                event_head { 0 };
+
+        /* perf_event group of this thread, the first descriptor leads */
+        std::array<int, PROFILE_COUNTER_COUNT> counter_fds { -1, -1, -1, -1 };
+        bool                                 counters_unavailable = false;
+
+        ProfileThreadData() = default;
+        ~ProfileThreadData();
+    };
+
+    inline void Profiler::Record(uint32_t section, uint64_t start, uint64_t end)
+    {
+        ProfileThreadData *data = t_data ? t_data : AcquireThreadData();
+        ProfileAggregate &agg = data->sections[section];
+        const uint64_t ticks = end - start;
+
+        constexpr auto relaxed = std::memory_order_relaxed;
+        agg.count.store(agg.count.load(relaxed) + 1, relaxed);
+        agg.ticks.store(agg.ticks.load(relaxed) + ticks, relaxed);
+        if (ticks < agg.min_ticks.load(relaxed)) agg.min_ticks.store(ticks, relaxed);
+        if (ticks > agg.max_ticks.load(relaxed)) agg.max_ticks.store(ticks, relaxed);
+
+        if (!agg.buckets) [[unlikely]] AllocateHistogram(agg);
+        std::atomic<uint64_t> &bucket = (*agg.buckets)[ProfileHistogram::BucketOf(ticks)];
+        bucket.store(bucket.load(relaxed) + 1, relaxed);
+
+        const uint32_t capacity = s_trace_capacity.load(relaxed);
+        if (capacity != 0 && ticks >= s_trace_min_ticks.load(relaxed))
+        {
+            if (!data->events) AllocateTraceBuffer(*data, capacity);
+
+            const uint64_t head = data->event_head.load(relaxed);
+            ProfileTraceEvent &event = data->events[head & data->event_mask];
+            event.section.store(section, relaxed);
+            event.start.store(start, relaxed);
+            event.end.store(end, relaxed);
+            data->event_head.store(head + 1, std::memory_order_release);
+        }
+    }
+
 }
 
 /* -------------------- compile-time helpers ------------------ */
@@ -63,11 +259,16 @@ namespace Utils {
 #define UNIQUE_VAR(prefix) CAT(prefix,__LINE__)
 
 #ifdef UTILS_RunProfile
-    #define PROFILE_FUNCTION(cat) \
-        Utils::Profiler UNIQUE_VAR(_prof_){ __FUNCTION__, Utils::ProfileCategory::cat }
-
+    // A single declaration, so that the macro cannot be split by an unbraced `if`. The section is
+    // interned once by the lambda's own static; `name` is evaluated outside it so that
+    // __FUNCTION__ still names the enclosing function.
     #define PROFILE_SCOPE(cat, name) \
-        Utils::Profiler UNIQUE_VAR(_prof_){ name, Utils::ProfileCategory::cat }
+        Utils::Profiler UNIQUE_VAR(_prof_){ [](std::string_view section_name) { \
+            static const uint32_t id = Utils::Profiler::RegisterSection(section_name, Utils::ProfileCategory::cat); \
+            return id; \
+        }(name) }
+
+    #define PROFILE_FUNCTION(cat) PROFILE_SCOPE(cat, __FUNCTION__)
 
     /* shorthands for Misc category */
     #define PROFILE_FUNCTION_AUTO() PROFILE_FUNCTION(Misc)
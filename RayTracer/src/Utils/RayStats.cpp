@@ -0,0 +1,89 @@
+#include "Utils/RayStats.h"
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace Utils {
+
+    namespace {
+
+        struct Registry
+        {
+            std::mutex                                       mutex;
+            std::vector<std::unique_ptr<RayStatsThreadData>> blocks;
+        };
+
+        Registry &GetRegistry()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+    }
+
+    thread_local RayStatsThreadData *RayStats::t_data = nullptr;
+
+    RayCounts RayCounts::operator-(const RayCounts &other) const
+    {
+        return {
+            primary_rays - other.primary_rays,
+            secondary_rays - other.secondary_rays,
+            shadow_rays - other.shadow_rays,
+            box_tests - other.box_tests,
+            primitive_tests - other.primitive_tests,
+            triangle_tests - other.triangle_tests,
+            hits - other.hits
+        };
+    }
+
+    RayStatsThreadData &RayStats::Acquire()
+    {
+        Registry &registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+
+        t_data = registry.blocks.emplace_back(std::make_unique<RayStatsThreadData>()).get();
+        return *t_data;
+    }
+
+    RayCounts RayStats::Snapshot()
+    {
+        Registry &registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+
+        constexpr auto relaxed = std::memory_order_relaxed;
+        RayCounts counts;
+        for (const auto &block : registry.blocks) {
+            counts.primary_rays    += block->primary_rays.load(relaxed);
+            counts.secondary_rays  += block->secondary_rays.load(relaxed);
+            counts.shadow_rays     += block->shadow_rays.load(relaxed);
+            counts.box_tests       += block->box_tests.load(relaxed);
+            counts.primitive_tests += block->primitive_tests.load(relaxed);
+            counts.triangle_tests  += block->triangle_tests.load(relaxed);
+            counts.hits            += block->hits.load(relaxed);
+        }
+        return counts;
+    }
+
+    void RayStats::LogSummary(const RayCounts &counts, double seconds)
+    {
+        const uint64_t rays = counts.Rays();
+        const double per_ray = rays > 0 ? 1.0 / double(rays) : 0.0;
+
+        std::ostringstream out;
+        out << "\n----- Ray Statistics -----\n"
+            << "primary rays:     " << counts.primary_rays << '\n'
+            << "secondary rays:   " << counts.secondary_rays << '\n'
+            << "shadow rays:      " << counts.shadow_rays << '\n'
+            << std::fixed << std::setprecision(2)
+            << "box tests:        " << counts.box_tests << "  (" << double(counts.box_tests) * per_ray << " per ray)\n"
+            << "primitive tests:  " << counts.primitive_tests << "  (" << double(counts.primitive_tests) * per_ray << " per ray)\n"
+            << "triangle tests:   " << counts.triangle_tests << "  (" << double(counts.triangle_tests) * per_ray << " per ray)\n"
+            << "hits:             " << counts.hits << "  (" << 100.0 * double(counts.hits) * per_ray << "% of rays)\n"
+            << "throughput:       " << (seconds > 0.0 ? double(rays) / seconds * 1e-6 : 0.0) << " Mrays/s\n";
+        std::cout << out.str();
+    }
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "Common/defs.h"
+
+namespace Utils {
+
+    /* ---------- one set of counters, summed over threads in snapshots ---------- */
+    struct RayCounts
+    {
+        uint64_t primary_rays    = 0;   // camera rays
+        uint64_t secondary_rays  = 0;   // reflected / refracted rays
+        uint64_t shadow_rays     = 0;   // light visibility queries
+        uint64_t box_tests       = 0;   // acceleration structure nodes visited
+        uint64_t primitive_tests = 0;   // scene level primitives tested
+        uint64_t triangle_tests  = 0;   // triangles tested inside meshes
+        uint64_t hits            = 0;   // scene queries that found a surface
+
+        inline uint64_t Rays() const { return primary_rays + secondary_rays + shadow_rays; }
+
+        RayCounts operator-(const RayCounts &other) const;
+    };
+
+    /* ------------- per-thread counters, written by their owner only ------------- */
+    struct RayStatsThreadData
+    {
+        std::atomic<uint64_t> primary_rays    { 0 };
+        std::atomic<uint64_t> secondary_rays  { 0 };
+        std::atomic<uint64_t> shadow_rays     { 0 };
+        std::atomic<uint64_t> box_tests       { 0 };
+        std::atomic<uint64_t> primitive_tests { 0 };
+        std::atomic<uint64_t> triangle_tests  { 0 };
+        std::atomic<uint64_t> hits            { 0 };
+    };
+
+    /**
+     * @brief Ray and traversal counters for judging acceleration changes.
+     *
+     * Every thread counts into its own block, so an increment is an uncontended relaxed store.
+     * Blocks are owned by a global registry and summed by `Snapshot`, which may run while other
+     * threads keep counting. Counting sites use the RAY_STATS_* macros, which compile to nothing
+     * unless `UTILS_RayStats` is defined.
+     */
+    class RayStats
+    {
+    public:
+        static inline RayStatsThreadData &Local() { return t_data ? *t_data : Acquire(); }
+
+        static inline void Add(std::atomic<uint64_t> &counter, uint64_t value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        /** @brief Sum over all threads that have counted so far. */
+        static RayCounts Snapshot();
+
+        /** @brief Prints totals and per-ray averages of `counts`, traced in `seconds`. */
+        static void LogSummary(const RayCounts &counts, double seconds);
+    private:
+        static thread_local RayStatsThreadData *t_data;
+        static RayStatsThreadData &Acquire();
+    };
+
+}
+
+#ifdef UTILS_RayStats
+    #define RAY_STATS_ADD(field, value) Utils::RayStats::Add(Utils::RayStats::Local().field, (value))
+    #define RAY_STATS_INC(field)        RAY_STATS_ADD(field, 1)
+#else
+    #define RAY_STATS_ADD(field, value) ((void)0)
+    #define RAY_STATS_INC(field)        ((void)0)
+#endif